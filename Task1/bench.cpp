@@ -0,0 +1,406 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "events.h"
+#include "flat_orderbook.h"
+#include "journal.h"
+#include "ledger.h"
+#include "orderbook.h"
+#include "replay.h"
+#include "snapshot.h"
+
+// Every heap allocation of the process goes through here, so the allocation check below can
+// tell whether matching touched the heap. Kept out of line so that GCC does not pair the
+// inlined malloc/free with new/delete expressions and warn about a mismatch.
+static std::atomic<uint64_t> heap_allocations{0};
+
+[[gnu::noinline]] void* operator new(std::size_t size) {
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* p) noexcept { std::free(p); }
+
+[[gnu::noinline]] void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// Folds every event into an FNV-1a hash, so two books can be compared fill by fill without
+// keeping their output around.
+class HashSink : public EventSink {
+private:
+    void mix(uint64_t value) {
+        for (int i = 0; i < 8; ++i) {
+            hash = (hash ^ ((value >> (i * 8)) & 0xff)) * 1099511628211ULL;
+        }
+    }
+
+public:
+    uint64_t hash = 1469598103934665603ULL;
+    uint64_t count = 0;
+
+    void consume(const Event* events, size_t n) override {
+        for (size_t i = 0; i < n; ++i) {
+            const Event& e = events[i];
+            mix(e.order_id);
+            mix(e.maker_order_id);
+            mix((uint64_t)e.user_id);
+            mix((uint64_t)e.maker_user_id);
+            mix((uint64_t)e.amount);
+            mix((uint64_t)e.price);
+            mix(((uint64_t)e.type << 8) | e.side);
+        }
+        count += n;
+    }
+};
+
+struct BenchOp {
+    enum Type : uint8_t { Add, Cancel, Modify } type;
+    Order order;
+};
+
+// Random order stream around a drifting mid price. `cancel_share` and `modify_share` of the
+// messages target one of the recently added orders (by the ID the book will assign to it).
+std::vector<BenchOp> generateOps(size_t count, uint32_t seed, double cancel_share, double modify_share) {
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<int64_t> users(1, 10000);
+    std::uniform_int_distribution<int64_t> amounts(1, 100);
+    std::geometric_distribution<int64_t> offsets(0.02);
+    std::uniform_int_distribution<int> coin(0, 1);
+    std::uniform_real_distribution<double> message(0.0, 1.0);
+
+    std::vector<BenchOp> ops;
+    ops.reserve(count);
+    std::vector<Order> added;
+    int64_t mid = 100000;
+    for (size_t i = 0; i < count; ++i) {
+        double kind = message(rng);
+        if (!added.empty() && kind < cancel_share + modify_share) {
+            std::uniform_int_distribution<size_t> recent(added.size() > 1000 ? added.size() - 1000 : 0, added.size() - 1);
+            size_t target = recent(rng);
+            Order order = added[target];
+            order.order_id = target + 1;
+            if (kind < cancel_share) {
+                ops.push_back({BenchOp::Cancel, order});
+            } else {
+                // Half of the modifies reduce in place, the rest move the order by a few ticks.
+                order.amount = amounts(rng);
+                if (coin(rng)) order.price += coin(rng) ? 2 : -2;
+                ops.push_back({BenchOp::Modify, order});
+            }
+            continue;
+        }
+
+        if (added.size() % 64 == 0) mid += coin(rng) ? 1 : -1;
+        bool side = coin(rng);
+        // Most orders rest a few ticks away from the mid, some cross it.
+        int64_t offset = offsets(rng) - 5;
+        int64_t price = side ? mid - offset : mid + offset;
+        Order order{users(rng), amounts(rng), price, side};
+        added.push_back(order);
+        ops.push_back({BenchOp::Add, order});
+    }
+    return ops;
+}
+
+// Turns the given shares of the added orders into IOC, FOK and market orders.
+void assignTypes(std::vector<BenchOp>& ops, uint32_t seed, double ioc_share, double fok_share, double market_share) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> kind(0.0, 1.0);
+    for (BenchOp& op : ops) {
+        if (op.type != BenchOp::Add) continue;
+        double k = kind(rng);
+        if (k < ioc_share) {
+            op.order.type = OrderType::ImmediateOrCancel;
+        } else if (k < ioc_share + fok_share) {
+            op.order.type = OrderType::FillOrKill;
+        } else if (k < ioc_share + fok_share + market_share) {
+            op.order.type = OrderType::Market;
+        }
+    }
+}
+
+// Times the matching thread only, events are hashed on the dispatcher thread.
+template <class Book>
+double run(const std::vector<BenchOp>& ops, HashSink& sink) {
+    EventRing events(1 << 20);
+    EventDispatcher dispatcher(events, sink);
+    Book book(&events);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const BenchOp& op : ops) {
+        switch (op.type) {
+            case BenchOp::Add: book.add_order(op.order); break;
+            case BenchOp::Cancel: book.cancel_order(op.order.order_id); break;
+            case BenchOp::Modify: book.modify_order(op.order.order_id, op.order.amount, op.order.price); break;
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    dispatcher.sync();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Median add_order latency of the stream with and without a (well funded) ledger attached.
+template <class Book>
+std::pair<uint64_t, uint64_t> risk_check_latency(const std::vector<BenchOp>& ops) {
+    uint64_t medians[2];
+    for (int with_ledger = 0; with_ledger < 2; ++with_ledger) {
+        Ledger ledger(10001);
+        for (int64_t user = 0; user <= 10000; ++user) {
+            ledger.deposit(user, UAH, (int64_t)1 << 40);
+            ledger.deposit(user, USD, (int64_t)1 << 50);
+        }
+        Book book;
+        if (with_ledger) book.attach_ledger(&ledger);
+
+        LatencyHistogram latency;
+        for (const BenchOp& op : ops) {
+            auto before = std::chrono::steady_clock::now();
+            book.add_order(op.order);
+            auto after = std::chrono::steady_clock::now();
+            latency.record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(after - before).count());
+        }
+        medians[with_ledger] = latency.percentile(50);
+    }
+    return {medians[0], medians[1]};
+}
+
+// Limit-only stream through add_order<LimitPolicy> directly and through the add_order overload
+// that dispatches on the order type, best of three runs each.
+template <class Book>
+std::pair<double, double> limit_dispatch_cost(const std::vector<BenchOp>& ops) {
+    double best[2] = {1e300, 1e300};
+    for (int round = 0; round < 3; ++round) {
+        for (int dispatched = 0; dispatched < 2; ++dispatched) {
+            Book book;
+            auto start = std::chrono::steady_clock::now();
+            for (const BenchOp& op : ops) {
+                if (dispatched) {
+                    book.add_order(op.order);
+                } else {
+                    book.template add_order<LimitPolicy>(op.order);
+                }
+            }
+            auto end = std::chrono::steady_clock::now();
+            best[dispatched] = std::min(best[dispatched], std::chrono::duration<double, std::milli>(end - start).count());
+        }
+    }
+    return {best[0], best[1]};
+}
+
+// Heap allocations made by the stream once the book is reserved for it and warmed up by its
+// first tenth (which also lays out the flat book's price band).
+template <class Book>
+uint64_t steady_state_allocations(const std::vector<BenchOp>& ops) {
+    Book book;
+    book.reserve(ops.size(), 1 << 16);
+    size_t warm_up = ops.size() / 10;
+    uint64_t before = 0;
+    for (size_t i = 0; i < ops.size(); ++i) {
+        if (i == warm_up) before = heap_allocations.load(std::memory_order_relaxed);
+        const BenchOp& op = ops[i];
+        switch (op.type) {
+            case BenchOp::Add: book.add_order(op.order); break;
+            case BenchOp::Cancel: book.cancel_order(op.order.order_id); break;
+            case BenchOp::Modify: book.modify_order(op.order.order_id, op.order.amount, op.order.price); break;
+        }
+    }
+    return heap_allocations.load(std::memory_order_relaxed) - before;
+}
+
+template <class Book>
+size_t resting_orders(const Book& book) {
+    size_t resting = 0;
+    for (bool side : {false, true}) {
+        book.for_each_resting(side, [&resting](const Order&) { resting++; });
+    }
+    return resting;
+}
+
+// Builds a book from the stream until at least `target` orders rest on it (counted every 64k
+// messages), snapshots it, restores it into a fresh book and checks that both show the same
+// top of book. Prints the resting order count and both timings.
+template <class Book>
+bool snapshot_round_trip(const char* name, const std::vector<BenchOp>& ops, size_t target) {
+    const std::string path = "bench_snapshot.bin";
+    Book book;
+    size_t resting = 0;
+    for (size_t i = 0; i < ops.size() && resting < target; ++i) {
+        book.add_order(ops[i].order);
+        if ((i + 1) % 65536 == 0 || i + 1 == ops.size()) resting = resting_orders(book);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    save_snapshot(book, nullptr, path, 0);
+    auto saved = std::chrono::steady_clock::now();
+    Book restored;
+    load_snapshot(restored, nullptr, path);
+    auto loaded = std::chrono::steady_clock::now();
+    std::remove(path.c_str());
+
+    std::vector<PriceLevel> bids, asks, restored_bids, restored_asks;
+    book.top_of_book(100, bids, asks);
+    restored.top_of_book(100, restored_bids, restored_asks);
+    auto same = [](const std::vector<PriceLevel>& a, const std::vector<PriceLevel>& b) {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const PriceLevel& x, const PriceLevel& y) {
+            return x.price == y.price && x.quantity == y.quantity;
+        });
+    };
+    std::cout << name << resting << " resting orders, save "
+              << std::chrono::duration<double, std::milli>(saved - start).count() << " ms, restore "
+              << std::chrono::duration<double, std::milli>(loaded - saved).count() << " ms" << std::endl;
+    return same(bids, restored_bids) && same(asks, restored_asks) &&
+           restored.last_assigned_id() == book.last_assigned_id();
+}
+
+// Orders with a non-positive amount, or a non-positive price on a non-market order, must be
+// rejected without an ID: none of them may rest, trade or shift a level total.
+template <class Book>
+bool invalid_orders_rejected() {
+    Book book;
+    Order market_order{3, 0, 0, true};
+    market_order.type = OrderType::Market;
+    const Order invalid[] = {{1, -5, 100, true}, {1, 0, 100, true}, {1, 5, 0, false}, {1, 5, -100, true}, market_order};
+    for (const Order& order : invalid) {
+        if (book.add_order(order) != 0) return false;
+    }
+    // Would have matched the negative bid above.
+    if (book.add_order(Order{2, 5, 100, false}) != 1) return false;
+
+    std::vector<PriceLevel> bids, asks;
+    book.top_of_book(10, bids, asks);
+    return book.trade_count() == 0 && bids.empty() && asks.size() == 1 && asks[0].price == 100 &&
+           asks[0].quantity == 5;
+}
+
+// The ledger must not let an order or deposit lower a reservation or wrap a notional: with
+// 100 USD deposited, only the one 100 USD bid below may reserve anything.
+template <class Book>
+bool risk_check_holds() {
+    Ledger ledger(10);
+    Book book;
+    book.attach_ledger(&ledger);
+    if (!ledger.deposit(1, USD, 100) || ledger.deposit(1, USD, -50) || ledger.deposit(1, USD, INT64_MAX)) return false;
+    if (ledger.reserve(1, USD, -50, 100) || ledger.reserve(1, USD, 50, -100) || ledger.reserve(1, USD, INT64_MAX / 2, 4)) {
+        return false;
+    }
+    if (book.add_order(Order{1, (int64_t)1 << 62, 4, true}) != 0) return false;
+    uint64_t id = book.add_order(Order{1, 1, 100, true});
+    if (id == 0 || !book.modify_order(id, 1, -100) || !book.modify_order(id, (int64_t)1 << 62, 4)) return false;
+
+    std::vector<PriceLevel> bids, asks;
+    book.top_of_book(10, bids, asks);
+    return ledger.reserved(1, USD) == 100 && ledger.balance(1, USD) == 100 && bids.size() == 1 &&
+           bids[0].price == 100 && bids[0].quantity == 1;
+}
+
+// Journals every message and waits for the last group commit.
+double journal_throughput(const std::vector<BenchOp>& ops) {
+    const std::string path = "bench_journal.bin";
+    std::remove(path.c_str());
+    auto start = std::chrono::steady_clock::now();
+    {
+        Journal journal(path);
+        for (const BenchOp& op : ops) {
+            journal.append({op.order.user_id, op.order.amount, op.order.price, OrderOp::Add, op.order.side,
+                            OrderType::Limit, 0, 0});
+        }
+        journal.sync();
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::remove(path.c_str());
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+struct Scenario {
+    const char* name;
+    double cancel_share;
+    double modify_share;
+    double ioc_share = 0.0;
+    double fok_share = 0.0;
+    double market_share = 0.0;
+};
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? std::stoull(argv[1]) : 1000000;
+    uint32_t seed = argc > 2 ? (uint32_t)std::stoul(argv[2]) : 42;
+    size_t snapshot_orders = argc > 3 ? std::stoull(argv[3]) : 1000000;
+
+    const Scenario scenarios[] = {
+        {"limit orders only", 0.0, 0.0},
+        {"80% cancels", 0.8, 0.0},
+        {"60% cancels, 20% modifies", 0.6, 0.2},
+        {"40% cancels, 20% IOC, 10% FOK, 5% market orders", 0.4, 0.0, 0.2, 0.1, 0.05},
+    };
+
+    std::cout << "Messages: " << count << " (seed " << seed << ")" << std::endl;
+    for (const Scenario& scenario : scenarios) {
+        std::vector<BenchOp> ops = generateOps(count, seed, scenario.cancel_share, scenario.modify_share);
+        assignTypes(ops, seed, scenario.ioc_share, scenario.fok_share, scenario.market_share);
+
+        HashSink map_out, flat_out;
+        double map_ms = run<Orderbook>(ops, map_out);
+        double flat_ms = run<FlatOrderbook>(ops, flat_out);
+
+        if (map_out.hash != flat_out.hash || map_out.count != flat_out.count) {
+            std::cerr << "Fill mismatch between Orderbook and FlatOrderbook (" << scenario.name << ")" << std::endl;
+            return 1;
+        }
+
+        std::cout << "--- " << scenario.name << " (output hash " << std::hex << map_out.hash << std::dec << ") ---" << std::endl;
+        std::cout << "Orderbook:     " << map_ms << " ms, " << (uint64_t)(count / map_ms * 1000) << " msgs/sec" << std::endl;
+        std::cout << "FlatOrderbook: " << flat_ms << " ms, " << (uint64_t)(count / flat_ms * 1000) << " msgs/sec" << std::endl;
+
+        uint64_t map_allocs = steady_state_allocations<Orderbook>(ops);
+        uint64_t flat_allocs = steady_state_allocations<FlatOrderbook>(ops);
+        std::cout << "Heap allocations once warm: " << map_allocs << " / " << flat_allocs << std::endl;
+        if (map_allocs != 0 || flat_allocs != 0) {
+            std::cerr << "Matching allocated on the heap after warm-up (" << scenario.name << ")" << std::endl;
+            return 1;
+        }
+    }
+
+    if (!invalid_orders_rejected<Orderbook>() || !invalid_orders_rejected<FlatOrderbook>()) {
+        std::cerr << "An order with a non-positive amount or price was accepted" << std::endl;
+        return 1;
+    }
+    if (!risk_check_holds<Orderbook>() || !risk_check_holds<FlatOrderbook>()) {
+        std::cerr << "The risk check let a reservation go negative or overflow" << std::endl;
+        return 1;
+    }
+
+    std::vector<BenchOp> ops = generateOps(count, seed, 0.0, 0.0);
+    auto [map_plain, map_risk] = risk_check_latency<Orderbook>(ops);
+    auto [flat_plain, flat_risk] = risk_check_latency<FlatOrderbook>(ops);
+    std::cout << "--- add_order median latency without / with risk checks ---" << std::endl;
+    std::cout << "Orderbook:     " << map_plain << " / " << map_risk << " ns" << std::endl;
+    std::cout << "FlatOrderbook: " << flat_plain << " / " << flat_risk << " ns" << std::endl;
+
+    auto [map_direct, map_dispatched] = limit_dispatch_cost<Orderbook>(ops);
+    auto [flat_direct, flat_dispatched] = limit_dispatch_cost<FlatOrderbook>(ops);
+    std::cout << "--- limit orders: add_order<LimitPolicy> / add_order dispatching on type ---" << std::endl;
+    std::cout << "Orderbook:     " << map_direct << " / " << map_dispatched << " ms" << std::endl;
+    std::cout << "FlatOrderbook: " << flat_direct << " / " << flat_dispatched << " ms" << std::endl;
+
+    std::cout << "--- snapshot / restore ---" << std::endl;
+    // About half of the limit orders of the stream stay on the book.
+    std::vector<BenchOp> snapshot_ops = generateOps(snapshot_orders * 5 / 2, seed, 0.0, 0.0);
+    if (!snapshot_round_trip<Orderbook>("Orderbook:     ", snapshot_ops, snapshot_orders) ||
+        !snapshot_round_trip<FlatOrderbook>("FlatOrderbook: ", snapshot_ops, snapshot_orders)) {
+        std::cerr << "Restored book differs from the snapshotted one" << std::endl;
+        return 1;
+    }
+    double journal_ms = journal_throughput(ops);
+    std::cout << "Journal (group commit): " << journal_ms << " ms, " << (uint64_t)(count / journal_ms * 1000)
+              << " msgs/sec durable" << std::endl;
+    return 0;
+}
@@ -0,0 +1,279 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "spsc_queue.h"
+
+// Index into the currency table (see Ledger, TextSink).
+using CurrencyId = uint8_t;
+
+// Currencies of the default UAH/USD instrument.
+enum Currency : CurrencyId {
+    UAH = 0,
+    USD = 1
+};
+
+struct Instrument {
+    std::string symbol;
+    CurrencyId base;
+    CurrencyId quote;
+};
+
+struct BalanceChange {
+    int64_t user_id;
+    int64_t value;
+    CurrencyId currency;
+};
+
+// How an incoming order treats the part it cannot fill right away: a limit order rests it,
+// IOC cancels it, FOK is only accepted if it can be filled in full, a market order takes the
+// best prices available regardless of its limit and cancels the rest.
+enum class OrderType : uint8_t {
+    Limit,
+    ImmediateOrCancel,
+    FillOrKill,
+    Market
+};
+
+enum class EventType : uint8_t {
+    Trade,
+    Rested,
+    Cancelled,
+    Modified,
+    Rejected
+};
+
+// Fixed-size record of everything the matching engine reports. For trades `order_id`/`user_id`
+// belong to the incoming (taker) order and `maker_*` to the resting one, `side` is the taker
+// side. For the other events `amount` is the resting amount of `order_id`. A rejected order
+// carries the amount and price it was submitted with, and no ID unless it was a modify. An IOC,
+// FOK or market order that is cancelled by the book reports its unfilled amount. `symbol` is the
+// index of the instrument the book trades.
+struct Event {
+    uint64_t order_id;
+    uint64_t maker_order_id;
+    int64_t user_id;
+    int64_t maker_user_id;
+    int64_t amount;
+    int64_t price;
+    EventType type;
+    bool side;
+    uint16_t reserved;
+    uint32_t symbol;
+};
+
+static_assert(sizeof(Event) == 56, "Event is written to disk as is");
+
+// Event stream of one order book. The producer never waits and no event is lost: while the
+// ring is full, events go to an unbounded overflow list behind a mutex, and keep going there
+// until the consumer has taken the list, so the consumer still sees them in order. The lock
+// is only taken on that slow path.
+class EventRing {
+private:
+    SpscQueue<Event> queue;
+    std::mutex overflow_mutex;
+    std::vector<Event> overflow;
+    std::atomic<bool> spilled{false};
+    std::atomic<uint64_t> spilled_count{0};
+    // Consumer side: the overflow list taken last, handed out before anything newer.
+    std::vector<Event> draining;
+    size_t draining_pos = 0;
+
+    size_t pop_draining(Event* out, size_t max) {
+        size_t n = std::min(max, draining.size() - draining_pos);
+        std::copy(draining.begin() + draining_pos, draining.begin() + draining_pos + n, out);
+        draining_pos += n;
+        return n;
+    }
+
+public:
+    explicit EventRing(size_t capacity = 1 << 16) : queue(capacity) {}
+
+    void push(const Event& event) {
+        if (!spilled.load(std::memory_order_acquire) && queue.try_push(event)) return;
+        std::lock_guard<std::mutex> lock(overflow_mutex);
+        overflow.push_back(event);
+        spilled_count.fetch_add(1, std::memory_order_relaxed);
+        spilled.store(true, std::memory_order_release);
+    }
+
+    size_t pop(Event* out, size_t max) {
+        if (draining_pos < draining.size()) return pop_draining(out, max);
+        size_t n = queue.pop(out, max);
+        if (n > 0 || !spilled.load(std::memory_order_acquire)) return n;
+        // Everything in the ring was pushed before the first overflowed event; the producer
+        // adds nothing to the ring until the overflow list has been taken.
+        n = queue.pop(out, max);
+        if (n > 0) return n;
+        draining.clear();
+        draining_pos = 0;
+        {
+            std::lock_guard<std::mutex> lock(overflow_mutex);
+            draining.swap(overflow);
+            spilled.store(false, std::memory_order_release);
+        }
+        return pop_draining(out, max);
+    }
+
+    uint64_t pushed() const { return queue.pushed() + spilled_count.load(std::memory_order_acquire); }
+
+    // Events that did not fit in the ring and went through the overflow list.
+    uint64_t spilled_events() const { return spilled_count.load(std::memory_order_acquire); }
+};
+
+class EventSink {
+public:
+    virtual ~EventSink() = default;
+    virtual void consume(const Event* events, size_t count) = 0;
+};
+
+class NullSink : public EventSink {
+public:
+    void consume(const Event*, size_t) override {}
+};
+
+// Console format of the original Orderbook.
+class TextSink : public EventSink {
+private:
+    std::ostream& out;
+    std::vector<Instrument> instruments;
+    std::vector<std::string> currencies;
+
+    void print_trade(const BalanceChange& change) {
+        out << "User " << change.user_id
+            << ": " << (change.value > 0 ? "+" : "") << change.value
+            << " " << currencies[change.currency] << "\n";
+    }
+
+    void print(const Event& event) {
+        switch (event.type) {
+            case EventType::Trade: {
+                const Instrument& instrument = instruments[event.symbol];
+                int64_t total_value = event.amount * event.price;
+                int64_t sign = event.side ? 1 : -1;
+
+                out << "--- MATCH EXECUTED (" << event.amount << " " << currencies[instrument.base] << " @ "
+                    << event.price << " " << currencies[instrument.quote] << ") ---\n";
+                print_trade({event.user_id, sign * event.amount, instrument.base});
+                print_trade({event.user_id, -sign * total_value, instrument.quote});
+
+                print_trade({event.maker_user_id, -sign * event.amount, instrument.base});
+                print_trade({event.maker_user_id, sign * total_value, instrument.quote});
+                out << "------------------------------------------\n";
+                break;
+            }
+            case EventType::Rested:
+                out << "Order placed in " << (event.side ? "BIDS" : "ASKS") << " (id: " << event.order_id
+                    << ", rest: " << event.amount << ")\n";
+                break;
+            case EventType::Cancelled:
+                out << "Order cancelled (id: " << event.order_id;
+                if (event.amount > 0) out << ", unfilled: " << event.amount;
+                out << ")\n";
+                break;
+            case EventType::Modified:
+                out << "Order modified (id: " << event.order_id << ", rest: " << event.amount << ")\n";
+                break;
+            case EventType::Rejected:
+                if (event.amount <= 0 || event.price <= 0) {
+                    out << "Order rejected: invalid amount or price (user: " << event.user_id << ")\n";
+                } else {
+                    out << "Order rejected: insufficient funds (user: " << event.user_id << ")\n";
+                }
+                break;
+        }
+    }
+
+public:
+    explicit TextSink(std::ostream& out = std::cout,
+                      std::vector<Instrument> instruments = {{"UAH/USD", UAH, USD}},
+                      std::vector<std::string> currencies = {"UAH", "USD"})
+        : out(out), instruments(std::move(instruments)), currencies(std::move(currencies)) {}
+
+    void consume(const Event* events, size_t count) override {
+        for (size_t i = 0; i < count; ++i) {
+            print(events[i]);
+        }
+        out.flush();
+    }
+};
+
+// Raw Event records, 56 bytes each.
+class BinarySink : public EventSink {
+private:
+    std::ofstream file;
+
+public:
+    explicit BinarySink(const std::string& path) : file(path, std::ios::binary) {
+        if (!file.is_open()) throw std::runtime_error("Cannot open event file: " + path);
+    }
+
+    void consume(const Event* events, size_t count) override {
+        file.write(reinterpret_cast<const char*>(events), (std::streamsize)(count * sizeof(Event)));
+    }
+};
+
+// Drains an EventRing into a sink on its own thread until destroyed.
+class EventDispatcher {
+private:
+    EventRing& ring;
+    EventSink& sink;
+    std::atomic<uint64_t> processed{0};
+    std::atomic<bool> running{true};
+    std::thread worker;
+
+    void run() {
+        std::vector<Event> batch(1024);
+        while (true) {
+            bool stopping = !running.load(std::memory_order_acquire);
+            size_t n = ring.pop(batch.data(), batch.size());
+            if (n > 0) {
+                sink.consume(batch.data(), n);
+                processed.fetch_add(n, std::memory_order_release);
+            } else if (stopping) {
+                break;
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+    }
+
+public:
+    EventDispatcher(EventRing& ring, EventSink& sink) : ring(ring), sink(sink), worker(&EventDispatcher::run, this) {}
+
+    ~EventDispatcher() {
+        running.store(false, std::memory_order_release);
+        worker.join();
+    }
+
+    EventDispatcher(const EventDispatcher&) = delete;
+    EventDispatcher& operator=(const EventDispatcher&) = delete;
+
+    // Waits until every event pushed so far has been handed to the sink.
+    void sync() const {
+        uint64_t target = ring.pushed();
+        while (processed.load(std::memory_order_acquire) < target) {
+            std::this_thread::yield();
+        }
+    }
+};
+
+// Sink by name: "text" (console), "null" or "binary" (raw events to `path`).
+inline std::unique_ptr<EventSink> make_sink(const std::string& name, const std::string& path = "events.bin") {
+    if (name == "text") return std::make_unique<TextSink>();
+    if (name == "null") return std::make_unique<NullSink>();
+    if (name == "binary") return std::make_unique<BinarySink>(path);
+    throw std::invalid_argument("Unknown sink: " + name);
+}
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "orderbook.h"
+
+// Price-indexed price levels: level i holds price base_price + i, resting orders live in one
+// contiguous pool and are chained into per-level FIFO queues by index. Order IDs map to pool
+// slots, so a resting order can be unlinked from the middle of its queue in O(1). Every level
+// keeps the running total of its orders, methods that change it return the new total.
+// The band starts at INITIAL_BAND ticks around the first price and doubles when a price falls
+// outside of it, up to MAX_BAND ticks. The order pool reuses freed slots and the ID index
+// takes its nodes from a PoolArena, so a warm (or reserved) book does not touch the heap.
+template <bool IsBid>
+class FlatLevels {
+private:
+    static constexpr uint32_t NIL = UINT32_MAX;
+    static constexpr int64_t INITIAL_BAND = 1 << 16;
+    static constexpr int64_t MAX_BAND = 1 << 24;
+
+    struct Node {
+        Order order;
+        uint32_t prev;
+        uint32_t next;
+    };
+
+    struct Level {
+        uint32_t head = NIL;
+        uint32_t tail = NIL;
+        int64_t total = 0;
+    };
+
+    std::vector<Node> pool;
+    uint32_t free_head = NIL;
+
+    std::vector<Level> levels;
+    std::vector<uint64_t> occupied;
+    int64_t base_price = 0;
+    int64_t best = -1;
+
+    using IdIndex = std::unordered_map<uint64_t, uint32_t, std::hash<uint64_t>, std::equal_to<uint64_t>,
+                                       PoolAllocator<std::pair<const uint64_t, uint32_t>>>;
+
+    PoolArena arena;
+    IdIndex by_id{0, std::hash<uint64_t>(), std::equal_to<uint64_t>(), typename IdIndex::allocator_type(arena)};
+
+    uint32_t allocate(const Order& order) {
+        if (free_head != NIL) {
+            uint32_t slot = free_head;
+            free_head = pool[slot].next;
+            pool[slot] = {order, NIL, NIL};
+            return slot;
+        }
+        pool.push_back({order, NIL, NIL});
+        return (uint32_t)(pool.size() - 1);
+    }
+
+    void release(uint32_t slot) {
+        pool[slot].next = free_head;
+        free_head = slot;
+    }
+
+    // First occupied level at or after `from` in priority order (up for asks, down for bids).
+    int64_t scan(int64_t from) const {
+        if constexpr (IsBid) {
+            if (from < 0) return -1;
+            int64_t word = from / 64;
+            int bit = (int)(from % 64);
+            uint64_t bits = occupied[word] & (bit == 63 ? ~0ULL : ((1ULL << (bit + 1)) - 1));
+            while (true) {
+                if (bits) return word * 64 + 63 - std::countl_zero(bits);
+                if (--word < 0) return -1;
+                bits = occupied[word];
+            }
+        } else {
+            if (from >= (int64_t)levels.size()) return -1;
+            int64_t word = from / 64;
+            uint64_t bits = occupied[word] & (~0ULL << (from % 64));
+            while (true) {
+                if (bits) return word * 64 + std::countr_zero(bits);
+                if (++word == (int64_t)occupied.size()) return -1;
+                bits = occupied[word];
+            }
+        }
+    }
+
+    void grow(int64_t below, int64_t above) {
+        if ((int64_t)levels.size() + below + above > MAX_BAND) {
+            throw std::out_of_range("Price is outside of the flat order book band");
+        }
+        levels.insert(levels.begin(), below, Level{});
+        levels.insert(levels.end(), above, Level{});
+        occupied.insert(occupied.begin(), below / 64, 0);
+        occupied.insert(occupied.end(), above / 64, 0);
+        base_price -= below;
+        if (best >= 0) best += below;
+    }
+
+    int64_t index_of(int64_t price) {
+        if (levels.empty()) {
+            base_price = price - INITIAL_BAND / 2;
+            levels.resize(INITIAL_BAND);
+            occupied.resize(INITIAL_BAND / 64);
+        }
+        int64_t size = (int64_t)levels.size();
+        int64_t index = price - base_price;
+        if (index < 0) {
+            grow(std::max(size, (-index + 63) / 64 * 64), 0);
+        } else if (index >= size) {
+            grow(0, std::max(size, (index - size + 64) / 64 * 64));
+        }
+        return price - base_price;
+    }
+
+    void unlink(uint32_t slot) {
+        Node& node = pool[slot];
+        int64_t index = node.order.price - base_price;
+        Level& level = levels[index];
+
+        if (node.prev == NIL) level.head = node.next; else pool[node.prev].next = node.next;
+        if (node.next == NIL) level.tail = node.prev; else pool[node.next].prev = node.prev;
+
+        if (level.head == NIL) {
+            occupied[index / 64] &= ~(1ULL << (index % 64));
+            if (index == best) {
+                best = scan(IsBid ? best - 1 : best + 1);
+            }
+        }
+        release(slot);
+    }
+
+public:
+    FlatLevels() = default;
+    FlatLevels(const FlatLevels&) = delete;
+    FlatLevels& operator=(const FlatLevels&) = delete;
+
+    // Pre-sizes the order pool and the ID index for `orders` resting orders. Levels are
+    // allocated as a band around the first price, so `price_levels` is not needed here.
+    void reserve(size_t orders, size_t /*price_levels*/) {
+        pool.reserve(orders);
+        by_id.reserve(orders);
+        IdIndex scratch(orders, std::hash<uint64_t>(), std::equal_to<uint64_t>(), typename IdIndex::allocator_type(arena));
+        for (size_t i = 0; i < orders; ++i) scratch.try_emplace(i);
+    }
+
+    bool empty() const { return best < 0; }
+
+    int64_t best_price() const { return base_price + best; }
+
+    Order& front() { return pool[levels[best].head].order; }
+
+    // Takes `quantity` off the front order.
+    int64_t fill_front(int64_t quantity) {
+        Level& level = levels[best];
+        pool[level.head].order.amount -= quantity;
+        level.total -= quantity;
+        return level.total;
+    }
+
+    void pop_front() {
+        uint32_t slot = levels[best].head;
+        by_id.erase(pool[slot].order.order_id);
+        unlink(slot);
+    }
+
+    int64_t push_back(const Order& order) {
+        int64_t index = index_of(order.price);
+        uint32_t slot = allocate(order);
+        Level& level = levels[index];
+        level.total += order.amount;
+        if (level.tail == NIL) {
+            level.head = slot;
+            occupied[index / 64] |= 1ULL << (index % 64);
+        } else {
+            pool[slot].prev = level.tail;
+            pool[level.tail].next = slot;
+        }
+        level.tail = slot;
+        by_id[order.order_id] = slot;
+
+        if (best < 0 || (IsBid ? index > best : index < best)) {
+            best = index;
+        }
+        return level.total;
+    }
+
+    const Order* find(uint64_t order_id) const {
+        auto it = by_id.find(order_id);
+        return it == by_id.end() ? nullptr : &pool[it->second].order;
+    }
+
+    // Lowers the amount of a resting order in place, keeping its queue position.
+    int64_t reduce(uint64_t order_id, int64_t new_amount) {
+        Order& order = pool[by_id.find(order_id)->second].order;
+        Level& level = levels[order.price - base_price];
+        level.total -= order.amount - new_amount;
+        order.amount = new_amount;
+        return level.total;
+    }
+
+    // Unlinks the order, copies it to `removed` and stores the new total of its level.
+    bool erase(uint64_t order_id, Order& removed, int64_t& level_total) {
+        auto it = by_id.find(order_id);
+        if (it == by_id.end()) return false;
+
+        removed = pool[it->second].order;
+        Level& level = levels[removed.price - base_price];
+        level.total -= removed.amount;
+        level_total = level.total;
+        unlink(it->second);
+        by_id.erase(it);
+        return true;
+    }
+
+    // Amount resting at prices no worse than `limit`, summed level by level from the best one
+    // until it reaches `needed`. `worst` receives the price of the last level summed.
+    int64_t liquidity(int64_t limit, int64_t needed, int64_t& worst) const {
+        int64_t sum = 0;
+        for (int64_t index = best; index >= 0 && sum < needed; index = scan(IsBid ? index - 1 : index + 1)) {
+            int64_t price = base_price + index;
+            if (IsBid ? price < limit : price > limit) break;
+            sum += levels[index].total;
+            worst = price;
+        }
+        return sum;
+    }
+
+    // Calls `f(order)` for every resting order, best level first, in queue order.
+    template <class F>
+    void for_each(F f) const {
+        for (int64_t index = best; index >= 0; index = scan(IsBid ? index - 1 : index + 1)) {
+            for (uint32_t slot = levels[index].head; slot != NIL; slot = pool[slot].next) f(pool[slot].order);
+        }
+    }
+
+    // Best `depth` levels in priority order.
+    void top(size_t depth, std::vector<PriceLevel>& out) const {
+        out.clear();
+        for (int64_t index = best; index >= 0 && out.size() < depth; index = scan(IsBid ? index - 1 : index + 1)) {
+            out.push_back({base_price + index, levels[index].total});
+        }
+    }
+};
+
+using FlatOrderbook = BasicOrderbook<FlatLevels>;
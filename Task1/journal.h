@@ -0,0 +1,219 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "order_log.h"
+#include "spsc_queue.h"
+
+#ifdef _WIN32
+    #include <fcntl.h>
+    #include <io.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+// One journaled message. Sequence numbers are consecutive, the checksum covers the sequence
+// and the record, so a torn write at the end of the journal is detected on restore.
+struct JournalEntry {
+    uint64_t sequence;
+    uint64_t checksum;
+    OrderRecord record;
+};
+
+static_assert(sizeof(JournalEntry) == 48, "JournalEntry is stored in the journal as is");
+
+inline uint64_t journal_checksum(uint64_t sequence, const OrderRecord& record) {
+    uint64_t hash = 1469598103934665603ULL;
+    auto mix = [&hash](const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ bytes[i]) * 1099511628211ULL;
+        }
+    };
+    mix(&sequence, sizeof(sequence));
+    mix(&record, sizeof(record));
+    return hash;
+}
+
+// Append-only write-ahead journal of order book messages. The matching thread only copies
+// entries into an SPSC queue. A flusher thread writes everything queued so far with one write
+// and one fdatasync (group commit), so the cost of a sync is shared by all messages that
+// arrived while the previous one was in progress.
+class Journal {
+private:
+    int fd;
+    SpscQueue<JournalEntry> queue;
+    uint64_t next_sequence;
+    std::atomic<uint64_t> durable_sequence;
+    std::atomic<bool> running{true};
+    std::thread flusher;
+
+    static void write_all(int fd, const char* data, size_t size) {
+        while (size > 0) {
+#ifdef _WIN32
+            int written = _write(fd, data, (unsigned)size);
+#else
+            ssize_t written = ::write(fd, data, size);
+#endif
+            if (written <= 0) throw std::runtime_error("Cannot write the journal");
+            data += written;
+            size -= (size_t)written;
+        }
+    }
+
+    static void sync_file(int fd) {
+#if defined(_WIN32)
+        _commit(fd);
+#elif defined(__APPLE__)
+        fsync(fd);
+#else
+        fdatasync(fd);
+#endif
+    }
+
+    // A failed write leaves the journal unusable and terminates the process, the book must not
+    // keep accepting orders it cannot recover.
+    void run() {
+        std::vector<JournalEntry> batch(4096);
+        while (true) {
+            bool stopping = !running.load(std::memory_order_acquire);
+            size_t n = queue.pop(batch.data(), batch.size());
+            if (n > 0) {
+                write_all(fd, reinterpret_cast<const char*>(batch.data()), n * sizeof(JournalEntry));
+                // Take whatever arrived during the write into the same sync.
+                size_t more;
+                while ((more = queue.pop(batch.data(), batch.size())) > 0) {
+                    write_all(fd, reinterpret_cast<const char*>(batch.data()), more * sizeof(JournalEntry));
+                    n = more;
+                }
+                sync_file(fd);
+                durable_sequence.store(batch[n - 1].sequence, std::memory_order_release);
+            } else if (stopping) {
+                break;
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+    }
+
+public:
+    // Appends to `path`, numbering new entries from `next_sequence` (see read_journal).
+    explicit Journal(const std::string& path, uint64_t next_sequence = 1, size_t capacity = 1 << 16)
+        : queue(capacity), next_sequence(next_sequence), durable_sequence(next_sequence - 1) {
+#ifdef _WIN32
+        fd = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, 0644);
+#else
+        fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+#endif
+        if (fd < 0) throw std::runtime_error("Cannot open journal " + path);
+        flusher = std::thread(&Journal::run, this);
+    }
+
+    ~Journal() {
+        running.store(false, std::memory_order_release);
+        flusher.join();
+#ifdef _WIN32
+        _close(fd);
+#else
+        close(fd);
+#endif
+    }
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // Queues the record and returns its sequence number. Only waits if the flusher is a whole
+    // queue behind.
+    uint64_t append(const OrderRecord& record) {
+        uint64_t sequence = next_sequence++;
+        JournalEntry entry{sequence, journal_checksum(sequence, record), record};
+        while (!queue.try_push(entry)) {
+            std::this_thread::yield();
+        }
+        return sequence;
+    }
+
+    // Sequence number of the last appended entry.
+    uint64_t last_sequence() const { return next_sequence - 1; }
+
+    // Sequence number up to which entries are on disk.
+    uint64_t durable() const { return durable_sequence.load(std::memory_order_acquire); }
+
+    // Waits until every appended entry is on disk.
+    void sync() const {
+        while (durable() < last_sequence()) {
+            std::this_thread::yield();
+        }
+    }
+
+    // Drops the journaled entries once a snapshot covers them. Numbering continues.
+    void reset() {
+        sync();
+#ifdef _WIN32
+        bool truncated = _chsize_s(fd, 0) == 0;
+#else
+        bool truncated = ftruncate(fd, 0) == 0;
+#endif
+        if (!truncated) throw std::runtime_error("Cannot truncate the journal");
+        sync_file(fd);
+    }
+};
+
+// Reads the valid prefix of a journal, calling `f(record)` for every entry after
+// `after_sequence`. A torn or corrupt tail is cut off so that new entries follow valid ones.
+// Returns the sequence number of the last valid entry (at least `after_sequence`).
+template <class F>
+uint64_t read_journal(const std::string& path, uint64_t after_sequence, F f) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) return after_sequence;
+
+    std::vector<JournalEntry> batch(4096);
+    uint64_t last = 0;
+    uint64_t valid_entries = 0;
+    bool corrupt = false;
+    while (!corrupt) {
+        in.read(reinterpret_cast<char*>(batch.data()), (std::streamsize)(batch.size() * sizeof(JournalEntry)));
+        size_t n = (size_t)in.gcount() / sizeof(JournalEntry);
+        for (size_t i = 0; i < n; ++i) {
+            const JournalEntry& entry = batch[i];
+            if (entry.checksum != journal_checksum(entry.sequence, entry.record) ||
+                (last != 0 && entry.sequence != last + 1)) {
+                corrupt = true;
+                break;
+            }
+            if (last == 0 && entry.sequence > after_sequence + 1) {
+                throw std::runtime_error("Journal " + path + " does not continue the snapshot");
+            }
+            last = entry.sequence;
+            valid_entries++;
+            if (entry.sequence > after_sequence) f(entry.record);
+        }
+        if (n < batch.size()) break;
+    }
+    in.close();
+
+    std::ifstream size_probe(path, std::ios::binary | std::ios::ate);
+    uint64_t valid_size = valid_entries * sizeof(JournalEntry);
+    if ((uint64_t)size_probe.tellg() != valid_size) {
+        size_probe.close();
+#ifdef _WIN32
+        int fd = _open(path.c_str(), _O_WRONLY | _O_BINARY);
+        bool truncated = fd >= 0 && _chsize_s(fd, (long long)valid_size) == 0;
+        if (fd >= 0) _close(fd);
+#else
+        bool truncated = truncate(path.c_str(), (off_t)valid_size) == 0;
+#endif
+        if (!truncated) throw std::runtime_error("Cannot cut the torn tail of " + path);
+    }
+    return std::max(last, after_sequence);
+}
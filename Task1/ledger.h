@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "events.h"
+
+// Per-user balances, preallocated for user IDs in [0, max_users) and `currency_count`
+// currencies. Open orders reserve what they may spend: a buy reserves amount * limit price of
+// the quote currency, a sell reserves amount of the base currency.
+class Ledger {
+public:
+    struct Account {
+        int64_t balance = 0;
+        int64_t reserved = 0;
+    };
+
+private:
+    int64_t max_users;
+    size_t currency_count;
+    std::vector<Account> accounts;
+
+    Account& account(int64_t user_id, CurrencyId currency) {
+        return accounts[(size_t)user_id * currency_count + currency];
+    }
+
+    const Account& account(int64_t user_id, CurrencyId currency) const {
+        return accounts[(size_t)user_id * currency_count + currency];
+    }
+
+public:
+    explicit Ledger(int64_t max_users, size_t currency_count = 2)
+        : max_users(max_users), currency_count(currency_count), accounts((size_t)max_users * currency_count) {}
+
+    bool has_user(int64_t user_id) const { return user_id >= 0 && user_id < max_users; }
+
+    // Fails for an unknown user or currency, a non-positive amount, or a balance that would
+    // overflow.
+    bool deposit(int64_t user_id, CurrencyId currency, int64_t amount) {
+        if (!has_user(user_id) || currency >= currency_count || amount <= 0) return false;
+        Account& acc = account(user_id, currency);
+        int64_t balance;
+        if (__builtin_add_overflow(acc.balance, amount, &balance)) return false;
+        acc.balance = balance;
+        return true;
+    }
+
+    // Reserves amount * price. Fails if the user is unknown, the amount or price is not
+    // positive, the product overflows, or the user has less than that available.
+    bool reserve(int64_t user_id, CurrencyId currency, int64_t amount, int64_t price = 1) {
+        if (!has_user(user_id) || amount <= 0 || price <= 0) return false;
+        int64_t notional;
+        if (__builtin_mul_overflow(amount, price, &notional)) return false;
+        Account& acc = account(user_id, currency);
+        if (acc.balance - acc.reserved < notional) return false;
+        acc.reserved += notional;
+        return true;
+    }
+
+    // Gives back amount * price of an earlier reservation, which bounds the product.
+    void release(int64_t user_id, CurrencyId currency, int64_t amount, int64_t price = 1) {
+        account(user_id, currency).reserved -= amount * price;
+    }
+
+    // Settles the balance changes of one trade and consumes the part of each side's
+    // reservation it covered. `buyer_limit` is the price the buyer's reservation was made at.
+    void settle(int64_t buyer_id, int64_t seller_id, CurrencyId base, CurrencyId quote,
+                int64_t quantity, int64_t price, int64_t buyer_limit) {
+        int64_t total_value = quantity * price;
+
+        Account& buyer_quote = account(buyer_id, quote);
+        buyer_quote.reserved -= quantity * buyer_limit;
+        buyer_quote.balance -= total_value;
+        account(buyer_id, base).balance += quantity;
+
+        Account& seller_base = account(seller_id, base);
+        seller_base.reserved -= quantity;
+        seller_base.balance -= quantity;
+        account(seller_id, quote).balance += total_value;
+    }
+
+    int64_t balance(int64_t user_id, CurrencyId currency) const { return account(user_id, currency).balance; }
+
+    int64_t reserved(int64_t user_id, CurrencyId currency) const { return account(user_id, currency).reserved; }
+
+    int64_t available(int64_t user_id, CurrencyId currency) const {
+        const Account& acc = account(user_id, currency);
+        return acc.balance - acc.reserved;
+    }
+
+    // Whole account table, user by user, for snapshots.
+    const std::vector<Account>& table() const { return accounts; }
+
+    // Replaces the account table with a snapshot of a ledger of the same size.
+    bool restore_table(const Account* table, size_t count) {
+        if (count != accounts.size()) return false;
+        accounts.assign(table, table + count);
+        return true;
+    }
+};
@@ -1,139 +1,263 @@
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
-#include <map>
-#include <list>
+#include <memory>
+#include <stdexcept>
+#include <sstream>
 #include <string>
-#include <limits>
+#include <thread>
+#include <vector>
 
-struct Order {
-    int64_t user_id;
-    int64_t amount;
-    int64_t price;
-    bool side;
-};
-
-struct BalanceChange {
-    int64_t user_id;
-    int64_t value;
-    std::string currency;
-};
+#ifdef TASK1_FLAT_ORDERBOOK
+#include "flat_orderbook.h"
+using Book = FlatOrderbook;
+#else
+#include "orderbook.h"
+using Book = Orderbook;
+#endif
+#include "events.h"
+#include "journal.h"
+#include "ledger.h"
+#include "market_data.h"
+#include "order_log.h"
+#include "replay.h"
+#include "sharded_engine.h"
+#include "snapshot.h"
 
 
-class Orderbook {
-private:
-
-    std::map<int64_t, std::list<Order>> asks;
-    std::map<int64_t, std::list<Order>, std::greater<>> bids;
-
-    static void print_trade(const BalanceChange& change) {
-        std::cout << "User " << change.user_id
-                  << ": " << (change.value > 0 ? "+" : "") << change.value
-                  << " " << change.currency << std::endl;
+void print_book(const Book& ob, size_t depth) {
+    std::vector<PriceLevel> bid_levels, ask_levels;
+    ob.top_of_book(depth, bid_levels, ask_levels);
+    for (size_t i = ask_levels.size(); i-- > 0;) {
+        std::cout << "  ASK " << ask_levels[i].price << " x " << ask_levels[i].quantity << std::endl;
+    }
+    for (const PriceLevel& level : bid_levels) {
+        std::cout << "  BID " << level.price << " x " << level.quantity << std::endl;
     }
+}
 
-    void process_buy(Order& order) {
-        while (order.amount>0 && !asks.empty()) {
-            auto best_ask = asks.begin();
+// Prints the level updates published by another Task1 process until interrupted.
+void listen_market_data(const std::string& name) {
+    std::unique_ptr<MarketDataRing> ring = MarketDataRing::open_shared(name);
+    MarketDataReader reader(*ring);
+    LevelUpdate update;
+    while (true) {
+        switch (reader.poll(update)) {
+            case MarketDataRing::ReadResult::Ok:
+                std::cout << "#" << update.sequence << " " << update.symbol << " " << (update.side ? "BID " : "ASK ")
+                          << update.price << " x " << update.quantity << "\n";
+                break;
+            case MarketDataRing::ReadResult::Empty:
+                std::cout.flush();
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                break;
+            case MarketDataRing::ReadResult::Overrun:
+                std::cout << "--- overrun, skipping to the latest update ---\n";
+                reader.skip_to_latest();
+                break;
+        }
+    }
+}
 
-            if (order.price<best_ask->first){break;}
+// Write-ahead journal and periodic snapshots of the console book. Both are optional.
+struct Persistence {
+    std::unique_ptr<Journal> journal;
+    std::string snapshot_path;
+    uint64_t snapshot_every = 100000;
+    const Ledger* ledger = nullptr;
+    uint64_t since_snapshot = 0;
 
-            std::list<Order>& order_list = best_ask->second;
-            Order& match_order = order_list.front();
+    // Loads the snapshot and replays the journal entries it does not cover, then opens the
+    // journal for appending. Returns the number of journal entries replayed.
+    uint64_t restore(Book& ob, Ledger* book_ledger, const std::string& journal_path) {
+        uint64_t sequence = snapshot_path.empty() ? 0 : load_snapshot(ob, book_ledger, snapshot_path);
+        if (journal_path.empty()) return 0;
+        uint64_t replayed = 0;
+        uint64_t last = read_journal(journal_path, sequence, [&ob, &replayed](const OrderRecord& record) {
+            try {
+                apply(ob, record);
+            } catch (const std::out_of_range&) {
+                // Rejected the same way when it was first entered.
+            }
+            replayed++;
+        });
+        journal = std::make_unique<Journal>(journal_path, last + 1);
+        return replayed;
+    }
 
-            execute_match(order, match_order);
+    void record(const OrderRecord& record) {
+        if (journal) journal->append(record);
+    }
 
-            if (match_order.amount == 0) {
-                order_list.pop_front();
-                if (order_list.empty()) {
-                    asks.erase(best_ask);
-                }
-            }
-        }
-        if (order.amount > 0) {
-            bids[order.price].push_back(order);
-            std::cout << "Order placed in BIDS (rest: " << order.amount << ")" << std::endl;
-        }
+    // Snapshots the book every `snapshot_every` journaled messages (or now, if `force`) and
+    // drops the journal entries the snapshot covers.
+    void checkpoint(const Book& ob, bool force = false) {
+        if (!journal || snapshot_path.empty()) return;
+        if (!force && ++since_snapshot < snapshot_every) return;
+        save_snapshot(ob, ledger, snapshot_path, journal->last_sequence());
+        journal->reset();
+        since_snapshot = 0;
     }
+};
 
-    void process_sell(Order& order) {
-        while (order.amount > 0 && !bids.empty()) {
-            auto best_bid = bids.begin();
+void run_console(Book& ob, EventDispatcher& dispatcher, Persistence& persistence) {
+    std::string line;
+    OrderRecord record;
 
-            if (order.price>best_bid->first){break;}
+    std::cout << "Orderbook Started. Enter orders format: [ID] [Amount] [Price] [1=Buy/0=Sell] [ioc/fok/mkt]" << std::endl;
+    std::cout << "Cancel: c [Order ID] | Modify: m [Order ID] [Amount] [Price]" << std::endl;
+    std::cout << "Deposit (with --risk): d [User ID] [UAH/USD] [Amount] | Book: b [Depth]" << std::endl;
 
-            std::list<Order>& order_list = best_bid->second;
-            Order& match_order = order_list.front();
+    while (true) {
+        std::cout << "> ";
+        if (!std::getline(std::cin, line)) break;
 
-            execute_match(order, match_order);
+        std::istringstream query(line);
+        std::string command;
+        size_t depth = 5;
+        if (query >> command && command == "b") {
+            query >> depth;
+            print_book(ob, depth);
+            continue;
+        }
 
-            if (match_order.amount == 0) {
-                order_list.pop_front();
-                if (order_list.empty()) {
-                    bids.erase(best_bid);
-                }
-            }
+        if (!parse_order_line(line, record)) {
+            std::cout << "Invalid input! Try again." << std::endl;
+            continue;
         }
-        if (order.amount > 0) {
-            asks[order.price].push_back(order);
-            std::cout << "Order placed in ASKS (rest: " << order.amount << ")" << std::endl;
+        persistence.record(record);
+        try {
+            if (!apply(ob, record)) {
+                std::cout << (record.op == OrderOp::Deposit ? "Deposit failed" : "Order not found") << std::endl;
+            }
+        } catch (const std::out_of_range& e) {
+            std::cout << e.what() << std::endl;
         }
+        persistence.checkpoint(ob);
+        // Let the sink catch up so the next prompt comes after this order's output.
+        dispatcher.sync();
     }
+    persistence.checkpoint(ob, true);
+}
 
-    void execute_match(Order& order, Order& match_order) {
-        int64_t trade_quantity = std::min(order.amount, match_order.amount);
-        int64_t trade_price = match_order.price;
-        int64_t total_value = trade_quantity * trade_price;
+// Usage:
+//   Task1 [--sink text|null|binary [file]] [--risk <max users>]   console mode
+//   Task1 --convert <orders.txt> <orders.bin>           text log -> binary order log
+//   Task1 --replay <orders.bin> [--sink ...] [--risk <max users>] replay a binary order log (null sink by default)
+//   Task1 --replay <orders.bin> --workers <N>           replay on N workers, one book per symbol, no --sink/--risk/--md
+//   Task1 ... --md <name>                               publish level updates to shared memory <name>
+//   Task1 --md-listen <name>                            print level updates published under <name>
+//   Task1 ... --journal <file> [--snapshot <file> [--snapshot-every <N>]]
+//                                                       console mode: restore, then journal every message
+int main(int argc, char** argv) {
+    std::string sink_name;
+    std::string sink_path = "events.bin";
+    std::string replay_path;
+    size_t workers = 0;
+    int64_t max_users = 0;
+    std::string md_name;
+    std::string journal_path;
+    Persistence persistence;
 
-        order.amount -= trade_quantity;
-        match_order.amount -= trade_quantity;
-
-        std::cout << "--- MATCH EXECUTED (" << trade_quantity << " UAH @ " << trade_price << " USD) ---" << std::endl;
-
-        if (order.side) {
-            print_trade({order.user_id, trade_quantity, "UAH"});
-            print_trade({order.user_id, -total_value, "USD"});
-
-            print_trade({match_order.user_id, -trade_quantity, "UAH"});
-            print_trade({match_order.user_id, total_value, "USD"});
-        } else {
-            print_trade({order.user_id, -trade_quantity, "UAH"});
-            print_trade({order.user_id, total_value, "USD"});
-
-            print_trade({match_order.user_id, trade_quantity, "UAH"});
-            print_trade({match_order.user_id, -total_value, "USD"});
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--sink") == 0 && i + 1 < argc) {
+            sink_name = argv[++i];
+            if (sink_name == "binary" && i + 1 < argc) sink_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            workers = std::stoul(argv[++i]);
+        } else if (std::strcmp(argv[i], "--risk") == 0 && i + 1 < argc) {
+            max_users = std::stoll(argv[++i]);
+        } else if (std::strcmp(argv[i], "--md") == 0 && i + 1 < argc) {
+            md_name = argv[++i];
+        } else if (std::strcmp(argv[i], "--journal") == 0 && i + 1 < argc) {
+            journal_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+            persistence.snapshot_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--snapshot-every") == 0 && i + 1 < argc) {
+            persistence.snapshot_every = std::stoull(argv[++i]);
+        } else if (std::strcmp(argv[i], "--md-listen") == 0 && i + 1 < argc) {
+            try {
+                listen_market_data(argv[i + 1]);
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--convert") == 0 && i + 2 < argc) {
+            try {
+                uint64_t count = convert_text_log(argv[i + 1], argv[i + 2]);
+                std::cout << "Converted " << count << " orders" << std::endl;
+                return 0;
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
         }
-        std::cout << "------------------------------------------" << std::endl;
     }
-public:
-    void add_order(Order order) {
-        if (order.side) {
-            process_buy(order);
-        } else {
-            process_sell(order);
-        }
+    if (!replay_path.empty() && workers > 0 && (!sink_name.empty() || max_users > 0 || !md_name.empty())) {
+        std::cerr << "--workers replays without events, risk checks or market data; "
+                     "drop --sink, --risk and --md or run without --workers" << std::endl;
+        return 1;
     }
+    if (sink_name.empty()) sink_name = replay_path.empty() ? "text" : "null";
 
-};
-
-
-int main() {
-    Orderbook ob;
-    int64_t id, amount, price;
-    int side_input;
+    if (!replay_path.empty() && workers > 0) {
+        try {
+            MappedOrderLog log(replay_path);
+            uint32_t instruments = 1;
+            for (const OrderRecord& record : log) {
+                instruments = std::max(instruments, record.symbol + 1);
+            }
+            ShardedEngine<Book> engine(instruments, workers);
+            replay_sharded(engine, log, std::cout);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
 
-    std::cout << "Orderbook Started. Enter orders format: [ID] [Amount] [Price] [1=Buy/0=Sell]" << std::endl;
+    try {
+        std::unique_ptr<EventSink> sink = make_sink(sink_name, sink_path);
+        EventRing events;
+        EventDispatcher dispatcher(events, *sink);
+        Book ob;
+        std::unique_ptr<Ledger> ledger;
+        if (max_users > 0) {
+            ledger = std::make_unique<Ledger>(max_users);
+            ob.attach_ledger(ledger.get());
+            persistence.ledger = ledger.get();
+        }
+        if (replay_path.empty() && !journal_path.empty()) {
+            auto start = std::chrono::steady_clock::now();
+            uint64_t replayed = persistence.restore(ob, ledger.get(), journal_path);
+            auto end = std::chrono::steady_clock::now();
+            std::cout << "Restored up to order ID " << ob.last_assigned_id() << " (" << replayed
+                      << " journal entries replayed) in " << std::chrono::duration<double, std::milli>(end - start).count()
+                      << " ms" << std::endl;
+        }
+        // Attached after the restore, so restoring prints nothing.
+        ob.attach_events(&events);
+        std::unique_ptr<MarketDataRing> market_data;
+        if (!md_name.empty()) {
+            market_data = MarketDataRing::create_shared(md_name, 1 << 20);
+            ob.attach_market_data(market_data.get());
+        }
 
-    while (true) {
-        std::cout << "> ";
-        if (!(std::cin >> id >> amount >> price >> side_input)) {
-            std::cin.clear();
-            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-            std::cout << "Invalid input! Try again." << std::endl;
-            continue;
+        if (replay_path.empty()) {
+            run_console(ob, dispatcher, persistence);
+        } else {
+            MappedOrderLog log(replay_path);
+            replay(ob, log, std::cout);
         }
 
-        ob.add_order({id, amount, price, (side_input == 1)});
+        dispatcher.sync();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
     }
-
     return 0;
-}
\ No newline at end of file
+}
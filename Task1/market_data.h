@@ -0,0 +1,203 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+// New total quantity at one price level. A quantity of 0 means the level is gone.
+struct LevelUpdate {
+    uint64_t sequence;
+    int64_t price;
+    int64_t quantity;
+    uint32_t symbol;
+    bool side;
+};
+
+// Broadcast ring of level updates with one writer and any number of readers. The writer never
+// waits for readers: it overwrites the oldest slot, and every slot is guarded by its sequence
+// number (seqlock), so a reader that falls a whole ring behind detects it instead of reading
+// torn data. The ring lives either in process memory or in a POSIX shared memory object, so
+// readers in other processes never contend with the matching thread.
+class MarketDataRing {
+private:
+    static constexpr char MAGIC[8] = {'O', 'B', 'L', '2', 'R', 'N', 'G', '1'};
+
+    // Payload words are atomics so that concurrent reads of a slot being rewritten are defined.
+    struct Slot {
+        std::atomic<uint64_t> sequence;
+        std::atomic<int64_t> price;
+        std::atomic<int64_t> quantity;
+        std::atomic<uint64_t> symbol_side;
+    };
+
+    struct Header {
+        char magic[8];
+        uint64_t capacity;
+        alignas(64) std::atomic<uint64_t> published;
+    };
+
+    Header* header = nullptr;
+    Slot* slots = nullptr;
+    size_t mask = 0;
+    uint64_t next_sequence = 1;
+
+    std::unique_ptr<char[]> local;
+    void* mapping = nullptr;
+    size_t mapping_size = 0;
+
+    static size_t bytes_for(uint64_t capacity) { return sizeof(Header) + capacity * sizeof(Slot); }
+
+    void attach(char* base) {
+        header = reinterpret_cast<Header*>(base);
+        slots = reinterpret_cast<Slot*>(base + sizeof(Header));
+        mask = header->capacity - 1;
+    }
+
+    void init(char* base, uint64_t capacity) {
+        Header* h = new (base) Header{};
+        std::memcpy(h->magic, MAGIC, sizeof(MAGIC));
+        h->capacity = capacity;
+        Slot* s = reinterpret_cast<Slot*>(base + sizeof(Header));
+        for (uint64_t i = 0; i < capacity; ++i) {
+            new (&s[i]) Slot{};
+        }
+        attach(base);
+    }
+
+    static uint64_t round_up(uint64_t capacity) {
+        uint64_t size = 1;
+        while (size < capacity) size <<= 1;
+        return size;
+    }
+
+    MarketDataRing() = default;
+
+public:
+    // In-process ring. Capacity is rounded up to a power of two.
+    explicit MarketDataRing(uint64_t capacity) {
+        capacity = round_up(capacity);
+        local = std::make_unique<char[]>(bytes_for(capacity));
+        init(local.get(), capacity);
+    }
+
+#ifndef _WIN32
+    // Creates (or replaces) the shared memory object `name` and publishes into it.
+    static std::unique_ptr<MarketDataRing> create_shared(const std::string& name, uint64_t capacity) {
+        capacity = round_up(capacity);
+        std::unique_ptr<MarketDataRing> ring(new MarketDataRing());
+        int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+        if (fd < 0) throw std::runtime_error("Cannot create shared memory " + name);
+        ring->mapping_size = bytes_for(capacity);
+        if (ftruncate(fd, (off_t)ring->mapping_size) != 0) {
+            close(fd);
+            throw std::runtime_error("Cannot size shared memory " + name);
+        }
+        ring->mapping = mmap(nullptr, ring->mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (ring->mapping == MAP_FAILED) {
+            ring->mapping = nullptr;
+            throw std::runtime_error("Cannot map shared memory " + name);
+        }
+        ring->init(static_cast<char*>(ring->mapping), capacity);
+        return ring;
+    }
+
+    // Maps an existing ring created by another process, for reading.
+    static std::unique_ptr<MarketDataRing> open_shared(const std::string& name) {
+        std::unique_ptr<MarketDataRing> ring(new MarketDataRing());
+        int fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0) throw std::runtime_error("Cannot open shared memory " + name);
+        Header probe;
+        if (pread(fd, &probe, sizeof(probe), 0) != (ssize_t)sizeof(probe) ||
+            std::memcmp(probe.magic, MAGIC, sizeof(MAGIC)) != 0) {
+            close(fd);
+            throw std::runtime_error("Not a market data ring: " + name);
+        }
+        ring->mapping_size = bytes_for(probe.capacity);
+        ring->mapping = mmap(nullptr, ring->mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (ring->mapping == MAP_FAILED) {
+            ring->mapping = nullptr;
+            throw std::runtime_error("Cannot map shared memory " + name);
+        }
+        ring->attach(static_cast<char*>(ring->mapping));
+        return ring;
+    }
+#endif
+
+    ~MarketDataRing() {
+#ifndef _WIN32
+        if (mapping) munmap(mapping, mapping_size);
+#endif
+    }
+
+    MarketDataRing(const MarketDataRing&) = delete;
+    MarketDataRing& operator=(const MarketDataRing&) = delete;
+
+    // Writer side, one thread only.
+    void publish(uint32_t symbol, bool side, int64_t price, int64_t quantity) {
+        uint64_t sequence = next_sequence++;
+        Slot& slot = slots[sequence & mask];
+        slot.sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.price.store(price, std::memory_order_relaxed);
+        slot.quantity.store(quantity, std::memory_order_relaxed);
+        slot.symbol_side.store(((uint64_t)symbol << 1) | (side ? 1 : 0), std::memory_order_relaxed);
+        slot.sequence.store(sequence, std::memory_order_release);
+        header->published.store(sequence, std::memory_order_release);
+    }
+
+    // Sequence number of the last published update, 0 if none.
+    uint64_t published() const { return header->published.load(std::memory_order_acquire); }
+
+    enum class ReadResult {
+        Ok,
+        Empty,
+        Overrun
+    };
+
+    // Reads update number `sequence`. Overrun means the writer has already reused its slot.
+    ReadResult read(uint64_t sequence, LevelUpdate& update) const {
+        if (sequence > published()) return ReadResult::Empty;
+        const Slot& slot = slots[sequence & mask];
+        if (slot.sequence.load(std::memory_order_acquire) != sequence) return ReadResult::Overrun;
+        update.price = slot.price.load(std::memory_order_relaxed);
+        update.quantity = slot.quantity.load(std::memory_order_relaxed);
+        uint64_t symbol_side = slot.symbol_side.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != sequence) return ReadResult::Overrun;
+        update.sequence = sequence;
+        update.symbol = (uint32_t)(symbol_side >> 1);
+        update.side = symbol_side & 1;
+        return ReadResult::Ok;
+    }
+};
+
+// Cursor of one market data consumer. After an overrun the consumer should take a fresh
+// snapshot and continue from `skip_to_latest`.
+class MarketDataReader {
+private:
+    const MarketDataRing& ring;
+    uint64_t next;
+
+public:
+    explicit MarketDataReader(const MarketDataRing& ring) : ring(ring), next(ring.published() + 1) {}
+
+    MarketDataRing::ReadResult poll(LevelUpdate& update) {
+        MarketDataRing::ReadResult result = ring.read(next, update);
+        if (result == MarketDataRing::ReadResult::Ok) next++;
+        return result;
+    }
+
+    void skip_to_latest() { next = ring.published() + 1; }
+};
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "events.h"
+
+#ifdef _WIN32
+    #include <iterator>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+enum class OrderOp : uint8_t {
+    Add,
+    Cancel,
+    Modify,
+    Deposit
+};
+
+// One order book message. `id` is the user ID for Add/Deposit and the order ID for
+// Cancel/Modify, `symbol` is the instrument index. A Deposit credits `amount` of the currency
+// with index `price`. `type` only applies to Add (older logs have 0 there, i.e. Limit).
+struct OrderRecord {
+    int64_t id;
+    int64_t amount;
+    int64_t price;
+    OrderOp op;
+    bool side;
+    OrderType type;
+    uint8_t reserved;
+    uint32_t symbol;
+};
+
+static_assert(sizeof(OrderRecord) == 32, "OrderRecord is stored in order logs as is");
+
+// Binary order log: this header followed by `count` packed OrderRecords.
+struct OrderLogHeader {
+    char magic[8];
+    uint64_t count;
+};
+
+inline constexpr char ORDER_LOG_MAGIC[8] = {'O', 'B', 'L', 'O', 'G', '1', 0, 0};
+
+// Parses one line of the console format:
+//   [User ID] [Amount] [Price] [1=Buy/0=Sell] [ioc|fok|mkt] | c [Order ID] | m [Order ID] [Amount] [Price]
+//   | d [User ID] [UAH/USD or currency index] [Amount]
+inline bool parse_order_line(const std::string& line, OrderRecord& record) {
+    std::istringstream in(line);
+    std::string command;
+    if (!(in >> command)) return false;
+
+    record = {};
+    if (command == "c") {
+        record.op = OrderOp::Cancel;
+        return (bool)(in >> record.id);
+    }
+    if (command == "m") {
+        record.op = OrderOp::Modify;
+        return (bool)(in >> record.id >> record.amount >> record.price);
+    }
+    if (command == "d") {
+        std::string currency;
+        record.op = OrderOp::Deposit;
+        if (!(in >> record.id >> currency >> record.amount)) return false;
+        if (currency == "UAH") {
+            record.price = UAH;
+        } else if (currency == "USD") {
+            record.price = USD;
+        } else {
+            try {
+                record.price = std::stoll(currency);
+            } catch (const std::exception&) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    int side_input;
+    in.clear();
+    in.seekg(0);
+    if (!(in >> record.id >> record.amount >> record.price >> side_input)) return false;
+    record.op = OrderOp::Add;
+    record.side = (side_input == 1);
+
+    std::string type;
+    if (!(in >> type)) return true;
+    if (type == "ioc") {
+        record.type = OrderType::ImmediateOrCancel;
+    } else if (type == "fok") {
+        record.type = OrderType::FillOrKill;
+    } else if (type == "mkt") {
+        record.type = OrderType::Market;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Converts a text order log (one console command per line) into a binary one. Unparsable lines
+// are skipped. Returns the number of records written.
+inline uint64_t convert_text_log(const std::string& text_path, const std::string& binary_path) {
+    std::ifstream in(text_path);
+    if (!in.is_open()) throw std::runtime_error("Cannot open " + text_path);
+    std::ofstream out(binary_path, std::ios::binary);
+    if (!out.is_open()) throw std::runtime_error("Cannot open " + binary_path);
+
+    OrderLogHeader header{};
+    std::memcpy(header.magic, ORDER_LOG_MAGIC, sizeof(header.magic));
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<OrderRecord> batch;
+    batch.reserve(1 << 16);
+    std::string line;
+    OrderRecord record;
+    while (std::getline(in, line)) {
+        if (!parse_order_line(line, record)) continue;
+        batch.push_back(record);
+        header.count++;
+        if (batch.size() == batch.capacity()) {
+            out.write(reinterpret_cast<const char*>(batch.data()), (std::streamsize)(batch.size() * sizeof(OrderRecord)));
+            batch.clear();
+        }
+    }
+    out.write(reinterpret_cast<const char*>(batch.data()), (std::streamsize)(batch.size() * sizeof(OrderRecord)));
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    return header.count;
+}
+
+// Read-only view of a binary order log, memory-mapped where available.
+class MappedOrderLog {
+private:
+    const OrderRecord* records = nullptr;
+    uint64_t record_count = 0;
+#ifdef _WIN32
+    std::vector<char> data;
+#else
+    void* mapping = MAP_FAILED;
+    size_t mapping_size = 0;
+#endif
+
+    void load(const char* base, size_t size, const std::string& path) {
+        OrderLogHeader header;
+        if (size < sizeof(header)) throw std::runtime_error("Not an order log: " + path);
+        std::memcpy(&header, base, sizeof(header));
+        if (std::memcmp(header.magic, ORDER_LOG_MAGIC, sizeof(header.magic)) != 0 ||
+            (size - sizeof(header)) / sizeof(OrderRecord) < header.count) {
+            throw std::runtime_error("Not an order log: " + path);
+        }
+        records = reinterpret_cast<const OrderRecord*>(base + sizeof(header));
+        record_count = header.count;
+    }
+
+public:
+    explicit MappedOrderLog(const std::string& path) {
+#ifdef _WIN32
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open()) throw std::runtime_error("Cannot open " + path);
+        data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        load(data.data(), data.size(), path);
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Cannot open " + path);
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            close(fd);
+            throw std::runtime_error("Not an order log: " + path);
+        }
+        mapping_size = (size_t)st.st_size;
+        mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED) throw std::runtime_error("Cannot map " + path);
+        madvise(mapping, mapping_size, MADV_SEQUENTIAL);
+        try {
+            load(static_cast<const char*>(mapping), mapping_size, path);
+        } catch (...) {
+            munmap(mapping, mapping_size);
+            throw;
+        }
+#endif
+    }
+
+    ~MappedOrderLog() {
+#ifndef _WIN32
+        if (mapping != MAP_FAILED) munmap(mapping, mapping_size);
+#endif
+    }
+
+    MappedOrderLog(const MappedOrderLog&) = delete;
+    MappedOrderLog& operator=(const MappedOrderLog&) = delete;
+
+    const OrderRecord* begin() const { return records; }
+    const OrderRecord* end() const { return records + record_count; }
+    uint64_t size() const { return record_count; }
+};
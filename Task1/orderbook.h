@@ -0,0 +1,522 @@
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "events.h"
+#include "ledger.h"
+#include "market_data.h"
+#include "pool_allocator.h"
+
+struct Order {
+    int64_t user_id;
+    int64_t amount;
+    int64_t price;
+    bool side;
+    uint64_t order_id = 0;
+    uint32_t symbol = 0;
+    OrderType type = OrderType::Limit;
+};
+
+// Order type policies for BasicOrderbook::add_order. They are resolved at compile time, so the
+// limit path has no extra branches.
+struct LimitPolicy {
+    static constexpr bool rests = true;
+    static constexpr bool all_or_none = false;
+    static constexpr bool market = false;
+};
+
+struct ImmediateOrCancelPolicy {
+    static constexpr bool rests = false;
+    static constexpr bool all_or_none = false;
+    static constexpr bool market = false;
+};
+
+struct FillOrKillPolicy {
+    static constexpr bool rests = false;
+    static constexpr bool all_or_none = true;
+    static constexpr bool market = false;
+};
+
+// Priced at the deepest level it needs, a market order then matches like an IOC order. This
+// also lets the risk check reserve what it can spend at most.
+struct MarketPolicy {
+    static constexpr bool rests = false;
+    static constexpr bool all_or_none = false;
+    static constexpr bool market = true;
+};
+
+// Aggregated price level as seen by market data: total resting amount at one price.
+struct PriceLevel {
+    int64_t price;
+    int64_t quantity;
+};
+
+// Node-based price levels: one std::map entry per price, one std::list node per resting order.
+// Resting orders are indexed by order ID, so they can be found and unlinked without a scan.
+// Every level keeps the running total of its orders, methods that change it return the new total.
+// All nodes come from a per-side PoolArena, so once the pools are warm (or reserved) adding,
+// matching and cancelling orders does not touch the heap.
+template <bool IsBid>
+class MapLevels {
+private:
+    using Compare = std::conditional_t<IsBid, std::greater<>, std::less<>>;
+    using OrderList = std::list<Order, PoolAllocator<Order>>;
+
+    struct Level {
+        OrderList orders;
+        int64_t total = 0;
+
+        explicit Level(const PoolAllocator<Order>& alloc) : orders(alloc) {}
+    };
+
+    using LevelMap = std::map<int64_t, Level, Compare, PoolAllocator<std::pair<const int64_t, Level>>>;
+
+    struct Location {
+        typename LevelMap::iterator level;
+        typename OrderList::iterator order;
+    };
+
+    using IdIndex = std::unordered_map<uint64_t, Location, std::hash<uint64_t>, std::equal_to<uint64_t>,
+                                       PoolAllocator<std::pair<const uint64_t, Location>>>;
+
+    // Declared first: the containers below return their nodes to it on destruction.
+    PoolArena arena;
+    PoolAllocator<Order> order_alloc{arena};
+    LevelMap levels{Compare(), typename LevelMap::allocator_type(arena)};
+    IdIndex by_id{0, std::hash<uint64_t>(), std::equal_to<uint64_t>(), typename IdIndex::allocator_type(arena)};
+
+public:
+    MapLevels() = default;
+    MapLevels(const MapLevels&) = delete;
+    MapLevels& operator=(const MapLevels&) = delete;
+
+    // Pre-sizes the pools for `orders` resting orders spread over `price_levels` levels. The node
+    // types are private to the standard library, so the pools are warmed by cycling nodes through
+    // scratch containers of the same types.
+    void reserve(size_t orders, size_t price_levels) {
+        by_id.reserve(orders);
+        {
+            OrderList scratch(order_alloc);
+            for (size_t i = 0; i < orders; ++i) scratch.emplace_back();
+        }
+        {
+            LevelMap scratch{Compare(), typename LevelMap::allocator_type(arena)};
+            for (size_t i = 0; i < price_levels; ++i) scratch.try_emplace((int64_t)i, order_alloc);
+        }
+        {
+            IdIndex scratch(orders, std::hash<uint64_t>(), std::equal_to<uint64_t>(), typename IdIndex::allocator_type(arena));
+            for (size_t i = 0; i < orders; ++i) scratch.try_emplace(i);
+        }
+    }
+
+    bool empty() const { return levels.empty(); }
+
+    int64_t best_price() const { return levels.begin()->first; }
+
+    Order& front() { return levels.begin()->second.orders.front(); }
+
+    // Takes `quantity` off the front order.
+    int64_t fill_front(int64_t quantity) {
+        Level& best = levels.begin()->second;
+        best.orders.front().amount -= quantity;
+        best.total -= quantity;
+        return best.total;
+    }
+
+    void pop_front() {
+        auto best = levels.begin();
+        OrderList& order_list = best->second.orders;
+        by_id.erase(order_list.front().order_id);
+        order_list.pop_front();
+        if (order_list.empty()) {
+            levels.erase(best);
+        }
+    }
+
+    int64_t push_back(const Order& order) {
+        auto level = levels.try_emplace(order.price, order_alloc).first;
+        level->second.orders.push_back(order);
+        level->second.total += order.amount;
+        by_id[order.order_id] = {level, std::prev(level->second.orders.end())};
+        return level->second.total;
+    }
+
+    const Order* find(uint64_t order_id) const {
+        auto it = by_id.find(order_id);
+        return it == by_id.end() ? nullptr : &*it->second.order;
+    }
+
+    // Lowers the amount of a resting order in place, keeping its queue position.
+    int64_t reduce(uint64_t order_id, int64_t new_amount) {
+        auto [level, order] = by_id.find(order_id)->second;
+        level->second.total -= order->amount - new_amount;
+        order->amount = new_amount;
+        return level->second.total;
+    }
+
+    // Unlinks the order, copies it to `removed` and stores the new total of its level.
+    bool erase(uint64_t order_id, Order& removed, int64_t& level_total) {
+        auto it = by_id.find(order_id);
+        if (it == by_id.end()) return false;
+
+        auto [level, order] = it->second;
+        removed = *order;
+        level->second.total -= order->amount;
+        level_total = level->second.total;
+        level->second.orders.erase(order);
+        if (level->second.orders.empty()) {
+            levels.erase(level);
+        }
+        by_id.erase(it);
+        return true;
+    }
+
+    // Amount resting at prices no worse than `limit`, summed level by level from the best one
+    // until it reaches `needed`. `worst` receives the price of the last level summed.
+    int64_t liquidity(int64_t limit, int64_t needed, int64_t& worst) const {
+        int64_t sum = 0;
+        for (auto it = levels.begin(); it != levels.end() && sum < needed; ++it) {
+            if (IsBid ? it->first < limit : it->first > limit) break;
+            sum += it->second.total;
+            worst = it->first;
+        }
+        return sum;
+    }
+
+    // Calls `f(order)` for every resting order, best level first, in queue order.
+    template <class F>
+    void for_each(F f) const {
+        for (const auto& [price, level] : levels) {
+            for (const Order& order : level.orders) f(order);
+        }
+    }
+
+    // Best `depth` levels in priority order.
+    void top(size_t depth, std::vector<PriceLevel>& out) const {
+        out.clear();
+        for (auto it = levels.begin(); it != levels.end() && out.size() < depth; ++it) {
+            out.push_back({it->first, it->second.total});
+        }
+    }
+};
+
+// Price-time priority matching on top of a price level container (see MapLevels, FlatLevels).
+// Fills and order state changes are pushed to an EventRing, formatting and I/O happen on the
+// consumer side of the ring (see EventDispatcher).
+template <template <bool> class Levels>
+class BasicOrderbook {
+private:
+
+    Levels<false> asks;
+    Levels<true> bids;
+    EventRing* events;
+    uint32_t symbol;
+    Ledger* ledger = nullptr;
+    MarketDataRing* market_data = nullptr;
+    CurrencyId base = UAH;
+    CurrencyId quote = USD;
+    uint64_t last_order_id = 0;
+    uint64_t trades = 0;
+
+    void emit(EventType type, const Order& order, int64_t amount) {
+        if (events) {
+            events->push({order.order_id, 0, order.user_id, 0, amount, order.price, type, order.side, 0, symbol});
+        }
+    }
+
+    void publish_level(bool side, int64_t price, int64_t quantity) {
+        if (market_data) market_data->publish(symbol, side, price, quantity);
+    }
+
+    // Reserves what the order may spend. False if the user cannot afford it.
+    bool reserve(const Order& order) {
+        if (!ledger) return true;
+        if (order.side) return ledger->reserve(order.user_id, quote, order.amount, order.price);
+        return ledger->reserve(order.user_id, base, order.amount);
+    }
+
+    void release(const Order& order) {
+        if (!ledger) return;
+        if (order.side) {
+            ledger->release(order.user_id, quote, order.amount, order.price);
+        } else {
+            ledger->release(order.user_id, base, order.amount);
+        }
+    }
+
+    // What is left of the incoming order after matching: a limit order rests it on its own
+    // side, other types cancel it.
+    template <class Policy, class Side>
+    void finish(Order& order, Side& own) {
+        if (order.amount <= 0) return;
+        if constexpr (Policy::rests) {
+            publish_level(order.side, order.price, own.push_back(order));
+            emit(EventType::Rested, order, order.amount);
+        } else {
+            release(order);
+            emit(EventType::Cancelled, order, order.amount);
+        }
+    }
+
+    template <class Policy>
+    void process_buy(Order& order) {
+        while (order.amount > 0 && !asks.empty()) {
+            if (order.price < asks.best_price()) {break;}
+
+            Order& match_order = asks.front();
+
+            execute_match(order, match_order, asks);
+
+            if (match_order.amount == 0) {
+                asks.pop_front();
+            }
+        }
+        finish<Policy>(order, bids);
+    }
+
+    template <class Policy>
+    void process_sell(Order& order) {
+        while (order.amount > 0 && !bids.empty()) {
+            if (order.price > bids.best_price()) {break;}
+
+            Order& match_order = bids.front();
+
+            execute_match(order, match_order, bids);
+
+            if (match_order.amount == 0) {
+                bids.pop_front();
+            }
+        }
+        finish<Policy>(order, asks);
+    }
+
+    // Amount the opposite side offers at prices no worse than `limit`, see Levels::liquidity.
+    int64_t liquidity(bool side, int64_t limit, int64_t needed, int64_t& worst) const {
+        return side ? asks.liquidity(limit, needed, worst) : bids.liquidity(limit, needed, worst);
+    }
+
+    // `match_order` is the front order of `levels`.
+    template <class Side>
+    void execute_match(Order& order, Order& match_order, Side& levels) {
+        int64_t trade_quantity = std::min(order.amount, match_order.amount);
+        int64_t trade_price = match_order.price;
+
+        order.amount -= trade_quantity;
+        publish_level(match_order.side, trade_price, levels.fill_front(trade_quantity));
+        trades++;
+
+        if (ledger) {
+            const Order& buyer = order.side ? order : match_order;
+            const Order& seller = order.side ? match_order : order;
+            ledger->settle(buyer.user_id, seller.user_id, base, quote, trade_quantity, trade_price, buyer.price);
+        }
+
+        if (events) {
+            events->push({order.order_id, match_order.order_id, order.user_id, match_order.user_id,
+                              trade_quantity, trade_price, EventType::Trade, order.side, 0, symbol});
+        }
+    }
+
+    template <class Policy = LimitPolicy>
+    void process_order(Order& order) {
+        try {
+            if (order.side) {
+                process_buy<Policy>(order);
+            } else {
+                process_sell<Policy>(order);
+            }
+        } catch (...) {
+            // The remainder could not be rested.
+            release(order);
+            throw;
+        }
+    }
+public:
+    // Without an event ring the book matches silently. `symbol` only tags the emitted events,
+    // routing orders of the right instrument here is up to the caller.
+    explicit BasicOrderbook(EventRing* events = nullptr, uint32_t symbol = 0) : events(events), symbol(symbol) {}
+
+    // Enables pre-trade risk checks: orders are only accepted if the user can cover them, and
+    // trades are settled in the ledger. `base`/`quote` are the currencies of this book's instrument.
+    void attach_ledger(Ledger* ledger, CurrencyId base = UAH, CurrencyId quote = USD) {
+        this->ledger = ledger;
+        this->base = base;
+        this->quote = quote;
+    }
+
+    // Replaces the event ring, e.g. to restore a book silently and attach the ring afterwards.
+    void attach_events(EventRing* events) {
+        this->events = events;
+    }
+
+    // Publishes the new total of every price level that changes.
+    void attach_market_data(MarketDataRing* market_data) {
+        this->market_data = market_data;
+    }
+
+    bool deposit(int64_t user_id, CurrencyId currency, int64_t amount) {
+        return ledger && ledger->deposit(user_id, currency, amount);
+    }
+
+    // Matches the order and handles the remainder as `Policy` says (see LimitPolicy and the
+    // others). Returns the ID assigned to the order, or 0 if it was rejected: a non-positive
+    // amount, a non-positive price on anything but a market order, or a failed risk check.
+    // Unfilled IOC, FOK and market orders still get an ID and a Cancelled event.
+    template <class Policy>
+    uint64_t add_order(Order order) {
+        if (order.amount <= 0 || (!Policy::market && order.price <= 0)) {
+            emit(EventType::Rejected, order, order.amount);
+            return 0;
+        }
+        if constexpr (Policy::market) {
+            int64_t worst = 0;
+            int64_t limit = order.side ? INT64_MAX : INT64_MIN;
+            if (liquidity(order.side, limit, order.amount, worst) == 0) {
+                order.order_id = ++last_order_id;
+                emit(EventType::Cancelled, order, order.amount);
+                return order.order_id;
+            }
+            order.price = worst;
+        }
+        if (!reserve(order)) {
+            emit(EventType::Rejected, order, order.amount);
+            return 0;
+        }
+        order.order_id = ++last_order_id;
+        if constexpr (Policy::all_or_none) {
+            // O(levels touched): level totals are kept up to date, no order queue is walked.
+            int64_t worst = 0;
+            if (liquidity(order.side, order.price, order.amount, worst) < order.amount) {
+                release(order);
+                emit(EventType::Cancelled, order, order.amount);
+                return order.order_id;
+            }
+        }
+        process_order<Policy>(order);
+        return order.order_id;
+    }
+
+    // Dispatches on `order.type` once, then runs the matching policy.
+    uint64_t add_order(const Order& order) {
+        switch (order.type) {
+            case OrderType::ImmediateOrCancel: return add_order<ImmediateOrCancelPolicy>(order);
+            case OrderType::FillOrKill: return add_order<FillOrKillPolicy>(order);
+            case OrderType::Market: return add_order<MarketPolicy>(order);
+            case OrderType::Limit: break;
+        }
+        return add_order<LimitPolicy>(order);
+    }
+
+    bool cancel_order(uint64_t order_id) {
+        Order removed{};
+        int64_t level_total = 0;
+        if (!asks.erase(order_id, removed, level_total) && !bids.erase(order_id, removed, level_total)) return false;
+        release(removed);
+        publish_level(removed.side, removed.price, level_total);
+
+        if (events) {
+            events->push({order_id, 0, 0, 0, 0, 0, EventType::Cancelled, false, 0, symbol});
+        }
+        return true;
+    }
+
+    // Reducing the amount at the same price keeps queue priority. Any other change re-enters
+    // the order under the same ID at the back of its new level, matching it first if it crosses.
+    // A change the user cannot afford, or to a non-positive price, is rejected and leaves the
+    // order as it was. Returns false if no resting order has this ID.
+    bool modify_order(uint64_t order_id, int64_t new_amount, int64_t new_price) {
+        if (new_amount <= 0) return cancel_order(order_id);
+
+        const Order* resting = asks.find(order_id);
+        if (!resting) resting = bids.find(order_id);
+        if (!resting) return false;
+
+        Order order = *resting;
+        order.amount = new_amount;
+        order.price = new_price;
+        if (new_price <= 0) {
+            emit(EventType::Rejected, order, order.amount);
+            return true;
+        }
+
+        if (new_price == resting->price && new_amount <= resting->amount) {
+            Order reduced = *resting;
+            reduced.amount -= new_amount;
+            release(reduced);
+            int64_t level_total = resting->side ? bids.reduce(order_id, new_amount) : asks.reduce(order_id, new_amount);
+            publish_level(resting->side, resting->price, level_total);
+            emit(EventType::Modified, *resting, new_amount);
+            return true;
+        }
+
+        release(*resting);
+        if (!reserve(order)) {
+            reserve(*resting);
+            emit(EventType::Rejected, order, order.amount);
+            return true;
+        }
+
+        Order removed{};
+        int64_t level_total = 0;
+        if (order.side) {
+            bids.erase(order_id, removed, level_total);
+        } else {
+            asks.erase(order_id, removed, level_total);
+        }
+        publish_level(removed.side, removed.price, level_total);
+        process_order(order);
+        return true;
+    }
+
+    // Pre-sizes both sides for `orders` resting orders on `price_levels` levels each, so that
+    // matching does not allocate until the book grows past that.
+    void reserve(size_t orders, size_t price_levels) {
+        asks.reserve(orders, price_levels);
+        bids.reserve(orders, price_levels);
+    }
+
+    uint64_t trade_count() const { return trades; }
+
+    // State for snapshots (see snapshot.h): resting orders of one side in priority order, so
+    // that restoring them in the same order rebuilds the queues.
+    template <class F>
+    void for_each_resting(bool side, F f) const {
+        if (side) {
+            bids.for_each(f);
+        } else {
+            asks.for_each(f);
+        }
+    }
+
+    uint64_t last_assigned_id() const { return last_order_id; }
+
+    // Puts a snapshotted order back at the end of its level, without matching, reservations
+    // (those come with the ledger snapshot) or events.
+    void restore_resting(const Order& order) {
+        int64_t level_total = order.side ? bids.push_back(order) : asks.push_back(order);
+        publish_level(order.side, order.price, level_total);
+    }
+
+    void restore_counters(uint64_t last_order_id, uint64_t trades) {
+        this->last_order_id = last_order_id;
+        this->trades = trades;
+    }
+
+    // Best `depth` aggregated levels of each side, best first. O(depth): level totals are kept
+    // up to date by matching, so no order queue is walked.
+    void top_of_book(size_t depth, std::vector<PriceLevel>& bid_levels, std::vector<PriceLevel>& ask_levels) const {
+        bids.top(depth, bid_levels);
+        asks.top(depth, ask_levels);
+    }
+
+};
+
+using Orderbook = BasicOrderbook<MapLevels>;
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Fixed-size blocks carved out of large chunks. Freed blocks go to a free list and are reused
+// first, so once the pool has reached its high-water mark it never calls the heap again.
+class NodePool {
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    static constexpr size_t MIN_CHUNK_BLOCKS = 256;
+
+    size_t block_size;
+    std::vector<std::unique_ptr<std::byte[]>> chunks;
+    FreeBlock* free_list = nullptr;
+    size_t free_count = 0;
+    size_t capacity = 0;
+
+    void grow(size_t blocks) {
+        chunks.push_back(std::make_unique<std::byte[]>(blocks * block_size));
+        std::byte* chunk = chunks.back().get();
+        for (size_t i = blocks; i-- > 0;) {
+            auto* block = reinterpret_cast<FreeBlock*>(chunk + i * block_size);
+            block->next = free_list;
+            free_list = block;
+        }
+        free_count += blocks;
+        capacity += blocks;
+    }
+
+public:
+    explicit NodePool(size_t size) {
+        size_t align = alignof(std::max_align_t);
+        block_size = (std::max(size, sizeof(FreeBlock)) + align - 1) / align * align;
+    }
+
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    size_t size() const { return block_size; }
+
+    void* allocate() {
+        // Chunks double in size, so the number of heap calls is logarithmic in the high-water mark.
+        if (!free_list) grow(std::max(MIN_CHUNK_BLOCKS, capacity));
+        FreeBlock* block = free_list;
+        free_list = block->next;
+        free_count--;
+        return block;
+    }
+
+    void deallocate(void* p) {
+        auto* block = static_cast<FreeBlock*>(p);
+        block->next = free_list;
+        free_list = block;
+        free_count++;
+    }
+
+    // Makes sure at least `blocks` blocks can be allocated without touching the heap.
+    void reserve(size_t blocks) {
+        if (free_count < blocks) grow(blocks - free_count);
+    }
+};
+
+// One NodePool per block size, shared by all allocators created from the arena.
+class PoolArena {
+private:
+    std::vector<std::unique_ptr<NodePool>> pools;
+
+public:
+    PoolArena() = default;
+    PoolArena(const PoolArena&) = delete;
+    PoolArena& operator=(const PoolArena&) = delete;
+
+    NodePool& pool_for(size_t size) {
+        for (auto& pool : pools) {
+            if (pool->size() >= size && pool->size() < size + alignof(std::max_align_t)) return *pool;
+        }
+        pools.push_back(std::make_unique<NodePool>(size));
+        return *pools.back();
+    }
+};
+
+// Standard allocator for node-based containers: single objects (list/map/hash nodes) come from
+// the arena, arrays (hash buckets) go to the heap, which only happens on rehash.
+template <class T>
+class PoolAllocator {
+private:
+    template <class U>
+    friend class PoolAllocator;
+
+    PoolArena* arena;
+    NodePool* pool;
+
+public:
+    using value_type = T;
+
+    static_assert(alignof(T) <= alignof(std::max_align_t), "Over-aligned types are not supported");
+
+    explicit PoolAllocator(PoolArena& arena) : arena(&arena), pool(&arena.pool_for(sizeof(T))) {}
+
+    template <class U>
+    PoolAllocator(const PoolAllocator<U>& other) : arena(other.arena), pool(&other.arena->pool_for(sizeof(T))) {}
+
+    T* allocate(size_t n) {
+        if (n == 1) return static_cast<T*>(pool->allocate());
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) {
+        if (n == 1) {
+            pool->deallocate(p);
+        } else {
+            std::allocator<T>().deallocate(p, n);
+        }
+    }
+
+    template <class U>
+    bool operator==(const PoolAllocator<U>& other) const { return arena == other.arena; }
+
+    template <class U>
+    bool operator!=(const PoolAllocator<U>& other) const { return arena != other.arena; }
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "order_log.h"
+
+// Log-linear latency histogram: exact below 512 ns, 512 sub-buckets per power of two above,
+// so recording is O(1) and percentiles are accurate to ~0.2% regardless of the sample count.
+class LatencyHistogram {
+private:
+    static constexpr int SUB_BITS = 9;
+    static constexpr uint64_t SUB_COUNT = 1 << SUB_BITS;
+
+    std::vector<uint64_t> buckets = std::vector<uint64_t>((64 - SUB_BITS + 1) * SUB_COUNT);
+    uint64_t total = 0;
+    uint64_t max_value = 0;
+
+    static size_t bucket_of(uint64_t value) {
+        if (value < SUB_COUNT) return (size_t)value;
+        int shift = std::bit_width(value) - SUB_BITS - 1;
+        return (size_t)((shift + 1) * SUB_COUNT + ((value >> shift) - SUB_COUNT));
+    }
+
+    static uint64_t value_of(size_t bucket) {
+        if (bucket < SUB_COUNT) return bucket;
+        int shift = (int)(bucket / SUB_COUNT) - 1;
+        return (SUB_COUNT + bucket % SUB_COUNT) << shift;
+    }
+
+public:
+    void record(uint64_t value) {
+        buckets[bucket_of(value)]++;
+        total++;
+        if (value > max_value) max_value = value;
+    }
+
+    uint64_t percentile(double p) const {
+        uint64_t rank = (uint64_t)(p / 100.0 * (double)total);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < buckets.size(); ++i) {
+            seen += buckets[i];
+            if (seen > rank) return value_of(i);
+        }
+        return max_value;
+    }
+
+    uint64_t max() const { return max_value; }
+};
+
+template <class Book>
+bool apply(Book& ob, const OrderRecord& record) {
+    switch (record.op) {
+        case OrderOp::Add:
+            ob.add_order({record.id, record.amount, record.price, record.side, 0, record.symbol, record.type});
+            return true;
+        case OrderOp::Cancel:
+            return ob.cancel_order((uint64_t)record.id);
+        case OrderOp::Modify:
+            return ob.modify_order((uint64_t)record.id, record.amount, record.price);
+        case OrderOp::Deposit:
+            return ob.deposit(record.id, (CurrencyId)record.price, record.amount);
+    }
+    return false;
+}
+
+// Feeds every record of the log through the book, timing each message. An order the book
+// throws out (a price outside the flat book's band) is counted as rejected, as the console and
+// the sharded engine do, and the replay goes on.
+template <class Book>
+void replay(Book& ob, const MappedOrderLog& log, std::ostream& report) {
+    using Clock = std::chrono::steady_clock;
+    LatencyHistogram latency;
+    uint64_t rejected = 0;
+
+    auto start = Clock::now();
+    for (const OrderRecord& record : log) {
+        auto before = Clock::now();
+        try {
+            apply(ob, record);
+        } catch (const std::out_of_range&) {
+            rejected++;
+        }
+        auto after = Clock::now();
+        latency.record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(after - before).count());
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    report << "Orders replayed: " << log.size() << " in " << seconds * 1000 << " ms" << std::endl;
+    report << "Orders/sec: " << (uint64_t)(log.size() / seconds) << std::endl;
+    report << "Trades: " << ob.trade_count() << ", trades/sec: " << (uint64_t)(ob.trade_count() / seconds) << std::endl;
+    if (rejected > 0) report << "Rejected (price outside of the book's band): " << rejected << std::endl;
+    report << "Latency (ns): p50 " << latency.percentile(50) << ", p99 " << latency.percentile(99)
+           << ", p999 " << latency.percentile(99.9) << ", max " << latency.max() << std::endl;
+}
+
+// Replays the log through a ShardedEngine-like engine. Messages are matched asynchronously, so
+// only throughput is reported.
+template <class Engine>
+void replay_sharded(Engine& engine, const MappedOrderLog& log, std::ostream& report) {
+    using Clock = std::chrono::steady_clock;
+
+    auto start = Clock::now();
+    for (const OrderRecord& record : log) {
+        engine.submit(record);
+    }
+    engine.drain();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    report << "Orders replayed: " << log.size() << " in " << seconds * 1000 << " ms on " << engine.worker_count()
+           << " workers" << std::endl;
+    report << "Orders/sec: " << (uint64_t)(log.size() / seconds) << std::endl;
+    report << "Trades: " << engine.trade_count() << ", trades/sec: " << (uint64_t)(engine.trade_count() / seconds) << std::endl;
+}
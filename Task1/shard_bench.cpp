@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "flat_orderbook.h"
+#include "order_log.h"
+#include "sharded_engine.h"
+
+// Multi-symbol stream: every message picks a random instrument, half of them cancel one of
+// the recent orders of that instrument (order IDs are assigned per book, starting from 1).
+std::vector<OrderRecord> generateRecords(size_t count, uint32_t instruments, uint32_t seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<uint32_t> symbols(0, instruments - 1);
+    std::uniform_int_distribution<int64_t> users(1, 10000);
+    std::uniform_int_distribution<int64_t> amounts(1, 100);
+    std::geometric_distribution<int64_t> offsets(0.02);
+    std::uniform_int_distribution<int> coin(0, 1);
+
+    std::vector<OrderRecord> records;
+    records.reserve(count);
+    std::vector<int64_t> added(instruments, 0);
+    std::vector<int64_t> mid(instruments, 100000);
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t symbol = symbols(rng);
+        OrderRecord record{};
+        record.symbol = symbol;
+        if (added[symbol] > 0 && coin(rng)) {
+            std::uniform_int_distribution<int64_t> recent(std::max<int64_t>(1, added[symbol] - 1000), added[symbol]);
+            record.op = OrderOp::Cancel;
+            record.id = recent(rng);
+        } else {
+            if (++added[symbol] % 64 == 0) mid[symbol] += coin(rng) ? 1 : -1;
+            record.op = OrderOp::Add;
+            record.side = coin(rng);
+            int64_t offset = offsets(rng) - 5;
+            record.id = users(rng);
+            record.amount = amounts(rng);
+            record.price = record.side ? mid[symbol] - offset : mid[symbol] + offset;
+        }
+        records.push_back(record);
+    }
+    return records;
+}
+
+// Usage: Task1_shard_bench [messages] [instruments] [max workers] [seed]
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? std::stoull(argv[1]) : 4000000;
+    uint32_t instruments = argc > 2 ? (uint32_t)std::stoul(argv[2]) : 64;
+    size_t max_workers = argc > 3 ? std::stoull(argv[3]) : std::max(1u, std::thread::hardware_concurrency());
+    uint32_t seed = argc > 4 ? (uint32_t)std::stoul(argv[4]) : 42;
+
+    std::vector<OrderRecord> records = generateRecords(count, instruments, seed);
+    std::cout << "Messages: " << count << ", instruments: " << instruments << " (seed " << seed << ")" << std::endl;
+
+    double single_rate = 0;
+    uint64_t expected_trades = 0;
+    for (size_t workers = 1; workers <= max_workers; ++workers) {
+        ShardedEngine<FlatOrderbook> engine(instruments, workers);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (const OrderRecord& record : records) {
+            engine.submit(record);
+        }
+        engine.drain();
+        auto end = std::chrono::high_resolution_clock::now();
+
+        double seconds = std::chrono::duration<double>(end - start).count();
+        double rate = count / seconds;
+        if (workers == 1) {
+            single_rate = rate;
+            expected_trades = engine.trade_count();
+        } else if (engine.trade_count() != expected_trades) {
+            std::cerr << "Trade count differs with " << workers << " workers" << std::endl;
+            return 1;
+        }
+        std::cout << "Workers " << workers << ": " << seconds * 1000 << " ms, " << (uint64_t)rate << " msgs/sec, "
+                  << "speedup " << rate / single_rate << "x, trades " << engine.trade_count() << std::endl;
+    }
+    return 0;
+}
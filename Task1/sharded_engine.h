@@ -0,0 +1,146 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+#include "events.h"
+#include "order_log.h"
+#include "replay.h"
+#include "spsc_queue.h"
+
+// Runs one order book per instrument, spread over worker threads. Instrument i is owned by
+// worker i % worker_count. Each worker gets its orders through its own SPSC queue and is the
+// only thread touching its books, so workers share no state.
+template <class Book>
+class ShardedEngine {
+private:
+    struct Worker {
+        SpscQueue<OrderRecord> input{1 << 16};
+        std::unique_ptr<EventRing> events;
+        std::unique_ptr<EventSink> sink;
+        std::unique_ptr<EventDispatcher> dispatcher;
+        std::vector<std::unique_ptr<Book>> books;
+        alignas(64) std::atomic<uint64_t> processed{0};
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<uint32_t> local_index;
+    std::vector<uint64_t> submitted;
+    std::atomic<bool> running{true};
+
+    void run(Worker& worker) {
+        OrderRecord batch[256];
+        while (true) {
+            size_t n = worker.input.pop(batch, 256);
+            if (n == 0) {
+                if (!running.load(std::memory_order_acquire)) break;
+                std::this_thread::yield();
+                continue;
+            }
+            for (size_t i = 0; i < n; ++i) {
+                try {
+                    apply(*worker.books[local_index[batch[i].symbol]], batch[i]);
+                } catch (const std::out_of_range&) {
+                    // Price outside of the book's band, the order is rejected.
+                }
+            }
+            worker.processed.fetch_add(n, std::memory_order_release);
+        }
+    }
+
+    static void pin(std::thread& thread, size_t cpu) {
+#ifdef __linux__
+        unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu % cpus, &set);
+        pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+        (void)thread;
+        (void)cpu;
+#endif
+    }
+
+public:
+    using SinkFactory = std::function<std::unique_ptr<EventSink>(size_t worker)>;
+
+    // Without a sink factory the books run without event streams.
+    ShardedEngine(size_t instrument_count, size_t worker_count, SinkFactory make_sink = nullptr)
+        : local_index(instrument_count), submitted(worker_count) {
+        for (size_t w = 0; w < worker_count; ++w) {
+            auto worker = std::make_unique<Worker>();
+            if (make_sink) {
+                worker->events = std::make_unique<EventRing>();
+                worker->sink = make_sink(w);
+                worker->dispatcher = std::make_unique<EventDispatcher>(*worker->events, *worker->sink);
+            }
+            workers.push_back(std::move(worker));
+        }
+        for (size_t symbol = 0; symbol < instrument_count; ++symbol) {
+            Worker& worker = *workers[symbol % worker_count];
+            local_index[symbol] = (uint32_t)worker.books.size();
+            worker.books.push_back(std::make_unique<Book>(worker.events.get(), (uint32_t)symbol));
+        }
+        for (size_t w = 0; w < worker_count; ++w) {
+            Worker& worker = *workers[w];
+            worker.thread = std::thread([this, &worker] { run(worker); });
+            pin(worker.thread, w);
+        }
+    }
+
+    ~ShardedEngine() {
+        running.store(false, std::memory_order_release);
+        for (auto& worker : workers) {
+            worker->thread.join();
+        }
+    }
+
+    ShardedEngine(const ShardedEngine&) = delete;
+    ShardedEngine& operator=(const ShardedEngine&) = delete;
+
+    // Routes the message to the worker owning its instrument, waiting while that worker's
+    // queue is full. Must be called from a single router thread.
+    void submit(const OrderRecord& record) {
+        if (record.symbol >= local_index.size()) throw std::out_of_range("Unknown instrument");
+        size_t w = record.symbol % workers.size();
+        while (!workers[w]->input.try_push(record)) {
+            std::this_thread::yield();
+        }
+        submitted[w]++;
+    }
+
+    // Waits until every submitted message has been matched.
+    void drain() {
+        for (size_t w = 0; w < workers.size(); ++w) {
+            while (workers[w]->processed.load(std::memory_order_acquire) < submitted[w]) {
+                std::this_thread::yield();
+            }
+            if (workers[w]->dispatcher) workers[w]->dispatcher->sync();
+        }
+    }
+
+    // Total trades so far, call after drain().
+    uint64_t trade_count() const {
+        uint64_t total = 0;
+        for (const auto& worker : workers) {
+            for (const auto& book : worker->books) {
+                total += book->trade_count();
+            }
+        }
+        return total;
+    }
+
+    size_t worker_count() const { return workers.size(); }
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ledger.h"
+#include "orderbook.h"
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+// Snapshot file: this header, `ask_count` + `bid_count` SnapshotOrders (asks first, each side
+// in priority order) and `account_count` ledger accounts. `sequence` is the last journal entry
+// the snapshot includes.
+struct SnapshotHeader {
+    char magic[8];
+    uint64_t sequence;
+    uint64_t last_order_id;
+    uint64_t trades;
+    uint64_t ask_count;
+    uint64_t bid_count;
+    uint64_t account_count;
+};
+
+struct SnapshotOrder {
+    uint64_t order_id;
+    int64_t user_id;
+    int64_t amount;
+    int64_t price;
+};
+
+inline constexpr char SNAPSHOT_MAGIC[8] = {'O', 'B', 'S', 'N', 'A', 'P', '1', 0};
+
+// Writes the book (and the ledger, if any) to `path`. The snapshot goes to a temporary file
+// first and is renamed over `path` once it is on disk, so a crash leaves the previous one.
+template <class Book>
+void save_snapshot(const Book& ob, const Ledger* ledger, const std::string& path, uint64_t sequence) {
+    SnapshotHeader header{};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.sequence = sequence;
+    header.last_order_id = ob.last_assigned_id();
+    header.trades = ob.trade_count();
+
+    std::vector<SnapshotOrder> orders;
+    auto collect = [&orders](const Order& order) {
+        orders.push_back({order.order_id, order.user_id, order.amount, order.price});
+    };
+    ob.for_each_resting(false, collect);
+    header.ask_count = orders.size();
+    ob.for_each_resting(true, collect);
+    header.bid_count = orders.size() - header.ask_count;
+    header.account_count = ledger ? ledger->table().size() : 0;
+
+    std::string temp_path = path + ".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) throw std::runtime_error("Cannot open " + temp_path);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(orders.data()), (std::streamsize)(orders.size() * sizeof(SnapshotOrder)));
+        if (ledger) {
+            out.write(reinterpret_cast<const char*>(ledger->table().data()),
+                      (std::streamsize)(header.account_count * sizeof(Ledger::Account)));
+        }
+        if (!out.flush()) throw std::runtime_error("Cannot write " + temp_path);
+    }
+#ifdef _WIN32
+    std::remove(path.c_str());
+#else
+    int fd = open(temp_path.c_str(), O_RDONLY);
+    bool synced = fd >= 0 && fsync(fd) == 0;
+    if (fd >= 0) close(fd);
+    if (!synced) throw std::runtime_error("Cannot sync " + temp_path);
+#endif
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Cannot replace " + path);
+    }
+}
+
+// Loads a snapshot into an empty book (and its ledger, which must have the same size as the
+// one it was taken from). Returns the journal sequence it includes, 0 if there is no snapshot.
+template <class Book>
+uint64_t load_snapshot(Book& ob, Ledger* ledger, const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) return 0;
+
+    SnapshotHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) {
+        throw std::runtime_error("Not a snapshot: " + path);
+    }
+
+    std::vector<SnapshotOrder> orders(header.ask_count + header.bid_count);
+    std::vector<Ledger::Account> accounts(header.account_count);
+    in.read(reinterpret_cast<char*>(orders.data()), (std::streamsize)(orders.size() * sizeof(SnapshotOrder)));
+    in.read(reinterpret_cast<char*>(accounts.data()), (std::streamsize)(accounts.size() * sizeof(Ledger::Account)));
+    if (!in) throw std::runtime_error("Truncated snapshot: " + path);
+
+    if (ledger && !ledger->restore_table(accounts.data(), accounts.size())) {
+        throw std::runtime_error("Snapshot " + path + " was taken with a different --risk size");
+    }
+
+    ob.reserve((size_t)std::max(header.ask_count, header.bid_count), 0);
+    for (size_t i = 0; i < orders.size(); ++i) {
+        const SnapshotOrder& o = orders[i];
+        bool side = i >= header.ask_count;
+        ob.restore_resting({o.user_id, o.amount, o.price, side, o.order_id});
+    }
+    ob.restore_counters(header.last_order_id, header.trades);
+    return header.sequence;
+}
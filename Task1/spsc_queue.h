@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Bounded single-producer / single-consumer queue. Neither side ever blocks: try_push fails
+// when the queue is full and pop returns 0 when it is empty.
+template <class T>
+class SpscQueue {
+private:
+    std::vector<T> buffer;
+    size_t mask;
+    alignas(64) std::atomic<uint64_t> head{0};
+    alignas(64) std::atomic<uint64_t> tail{0};
+
+public:
+    // Capacity is rounded up to a power of two.
+    explicit SpscQueue(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        buffer.resize(size);
+        mask = size - 1;
+    }
+
+    bool try_push(const T& item) {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == buffer.size()) return false;
+        buffer[h & mask] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t pop(T* out, size_t max) {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        uint64_t available = head.load(std::memory_order_acquire) - t;
+        size_t n = available < max ? (size_t)available : max;
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = buffer[(t + i) & mask];
+        }
+        tail.store(t + n, std::memory_order_release);
+        return n;
+    }
+
+    // Number of items ever pushed.
+    uint64_t pushed() const { return head.load(std::memory_order_acquire); }
+};
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "maze.h"
+
+// Indices [0, count) split into one range per worker. A worker takes indices from the front of
+// its own range; when that is empty it steals the back half of the largest range left. Each
+// range is one atomic word (begin << 32 | end), so taking and stealing are single CASes.
+class WorkStealingRanges {
+private:
+    struct alignas(64) Range {
+        std::atomic<uint64_t> bounds{0};
+    };
+
+    std::vector<Range> ranges;
+
+    static uint64_t Pack(uint32_t begin, uint32_t end) { return ((uint64_t)begin << 32) | end; }
+
+    static uint32_t Begin(uint64_t bounds) { return (uint32_t)(bounds >> 32); }
+
+    static uint32_t End(uint64_t bounds) { return (uint32_t)bounds; }
+
+    bool TakeFront(size_t worker, uint32_t& index) {
+        std::atomic<uint64_t>& own = ranges[worker].bounds;
+        uint64_t bounds = own.load(std::memory_order_acquire);
+        while (Begin(bounds) < End(bounds)) {
+            if (own.compare_exchange_weak(bounds, Pack(Begin(bounds) + 1, End(bounds)), std::memory_order_acq_rel)) {
+                index = Begin(bounds);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Moves the back half of the largest range into the (empty) range of `worker`.
+    bool Steal(size_t worker) {
+        while (true) {
+            size_t victim = ranges.size();
+            uint64_t victimBounds = 0;
+            uint32_t largest = 0;
+            for (size_t i = 0; i < ranges.size(); i++) {
+                uint64_t bounds = ranges[i].bounds.load(std::memory_order_acquire);
+                uint32_t remaining = End(bounds) - std::min(Begin(bounds), End(bounds));
+                if (remaining > largest) {
+                    largest = remaining;
+                    victim = i;
+                    victimBounds = bounds;
+                }
+            }
+            if (victim == ranges.size()) return false;
+
+            uint32_t middle = Begin(victimBounds) + largest / 2;
+            if (ranges[victim].bounds.compare_exchange_strong(victimBounds, Pack(Begin(victimBounds), middle),
+                                                              std::memory_order_acq_rel)) {
+                ranges[worker].bounds.store(Pack(middle, End(victimBounds)), std::memory_order_release);
+                return true;
+            }
+        }
+    }
+
+public:
+    WorkStealingRanges(uint32_t count, size_t workers) : ranges(workers) {
+        for (size_t w = 0; w < workers; w++) {
+            ranges[w].bounds.store(Pack((uint32_t)(count * w / workers), (uint32_t)(count * (w + 1) / workers)));
+        }
+    }
+
+    // Next index for `worker`, false once every index has been handed out.
+    bool Next(size_t worker, uint32_t& index) {
+        while (!TakeFront(worker, index)) {
+            if (!Steal(worker)) return false;
+        }
+        return true;
+    }
+};
+
+// Batch file: this header followed by `count` mazes of Maze::PackedSize() bytes each, maze i
+// built from MazeSeed(baseSeed, i). Every maze has a fixed offset, so the file is the same
+// whatever the number of threads that wrote it.
+struct MazeBatchHeader {
+    char magic[8];
+    uint64_t count;
+    uint32_t rows;
+    uint32_t columns;
+    uint64_t baseSeed;
+};
+
+inline constexpr char MAZE_BATCH_MAGIC[8] = {'M', 'A', 'Z', 'E', 'B', 'A', 'T', '1'};
+
+// Builds `count` mazes on `threads` workers and writes them to `path`. Each worker reuses one
+// Maze (grid and RNG) and one output buffer for all of its mazes.
+inline void GenerateBatch(const std::string& path, uint32_t count, int rows, int columns, uint64_t baseSeed,
+                          size_t threads) {
+    size_t packedSize = Maze::PackedSize(rows, columns);
+
+    MazeBatchHeader header{};
+    std::memcpy(header.magic, MAZE_BATCH_MAGIC, sizeof(header.magic));
+    header.count = count;
+    header.rows = (uint32_t)Maze::OddSide(rows);
+    header.columns = (uint32_t)Maze::OddSide(columns);
+    header.baseSeed = baseSeed;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) throw std::runtime_error("Cannot open " + path);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::mutex outMutex;
+    WorkStealingRanges work(count, threads);
+    auto run = [&](size_t worker) {
+        Maze maze(rows, columns, 0);
+        std::vector<uint8_t> packed(packedSize);
+        uint32_t index;
+        while (work.Next(worker, index)) {
+            maze.Seed(MazeSeed(baseSeed, index));
+            maze.Build();
+            maze.Pack(packed.data());
+
+            std::lock_guard<std::mutex> lock(outMutex);
+            out.seekp((std::streamoff)(sizeof(header) + (uint64_t)index * packedSize));
+            out.write(reinterpret_cast<const char*>(packed.data()), (std::streamsize)packedSize);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t w = 1; w < threads; w++) {
+        workers.emplace_back(run, w);
+    }
+    run(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    if (!out.flush()) throw std::runtime_error("Cannot write " + path);
+}
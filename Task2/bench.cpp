@@ -0,0 +1,421 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+#include "maze.h"
+#include "maze_file.h"
+#include "routes.h"
+
+size_t getPeakMemory() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS info;
+    GetProcessMemoryInfo(GetCurrentProcess(), &info, sizeof(info));
+    return (size_t)info.PeakWorkingSetSize;
+#else
+    struct rusage r_usage;
+    getrusage(RUSAGE_SELF, &r_usage);
+#ifdef __APPLE__
+    return (size_t)r_usage.ru_maxrss;
+#else
+    return (size_t)(r_usage.ru_maxrss * 1024);
+#endif
+#endif
+}
+
+// Compares IsSolvable with the reference BFS on random grids: built mazes with extra walls
+// opened (so there are loops and more than one way past a trap) and random traps, and
+// unstructured grids of walls, roads and traps. Returns the number of mismatches.
+int checkSolvers(int trials) {
+    std::mt19937 rng(12345);
+    int mismatches = 0;
+    for (int trial = 0; trial < trials; trial++) {
+        int rows = std::uniform_int_distribution<int>(3, 41)(rng);
+        int columns = std::uniform_int_distribution<int>(3, trial % 4 == 0 ? 200 : 41)(rng);
+        Maze maze(rows, columns, rng());
+        maze.Build();
+
+        bool unstructured = trial % 2 == 1;
+        double openChance = std::uniform_real_distribution<double>(0, 0.5)(rng);
+        double trapChance = std::uniform_real_distribution<double>(0, 0.3)(rng);
+        std::uniform_real_distribution<double> chance(0, 1);
+        for (int y = 1; y < maze.Rows() - 1; y++) {
+            for (int x = 1; x < maze.Columns() - 1; x++) {
+                CellType type = maze.At(x, y);
+                if (type == ENTRANCE || type == EXIT) continue;
+                if (unstructured || (type == WALL && chance(rng) < openChance)) {
+                    type = chance(rng) < 0.4 ? WALL : ROAD;
+                }
+                if (type == ROAD && chance(rng) < trapChance) type = TRAP;
+                maze.Set(x, y, type);
+            }
+        }
+
+        if (maze.IsSolvable() != maze.IsSolvableBfs()) {
+            if (mismatches++ == 0) {
+                std::cout << "Solvers disagree on this maze:\n";
+                maze.Print();
+            }
+        }
+    }
+    return mismatches;
+}
+
+#ifdef _WIN32
+const char* NULL_DEVICE = "nul";
+#else
+const char* NULL_DEVICE = "/dev/null";
+#endif
+
+// The console output as Maze::Print wrote it before rendering into a buffer: one stream
+// insertion per glyph and per space.
+void printPerCell(const Maze& maze, std::ostream& out) {
+    for (int y = 0; y < maze.Rows(); y++) {
+        for (int x = 0; x < maze.Columns(); x++) {
+            int cell = maze.At(x, y);
+            char c = '#';
+            if (cell == ROAD) c = ' ';
+            else if (cell == ENTRANCE) c = 'S';
+            else if (cell == EXIT) c = 'E';
+            else if (cell == TRAP) c = '0';
+            else if (cell == TREASURE) c = 'T';
+            out << c << " ";
+        }
+        out << "\n";
+    }
+}
+
+// Checks that Render matches the per-cell output and that packed and mapped files give back the
+// same cells. Returns the number of failures.
+int checkExport(int trials) {
+    std::mt19937 rng(777);
+    int failures = 0;
+    std::string path = "bench_check.maze";
+    for (int trial = 0; trial < trials; trial++) {
+        Maze maze(std::uniform_int_distribution<int>(3, 80)(rng), std::uniform_int_distribution<int>(3, 80)(rng), rng());
+        maze.Build();
+
+        std::ostringstream expected;
+        printPerCell(maze, expected);
+        if (maze.Render() != expected.str()) failures++;
+
+        std::vector<uint8_t> cells((size_t)maze.Rows() * maze.Columns());
+        maze.CopyTypes(cells.data());
+
+        SavePackedMaze(maze, path);
+        Maze decoded = LoadPackedMaze(path);
+        std::vector<uint8_t> decodedCells(cells.size());
+        decoded.CopyTypes(decodedCells.data());
+        if (decodedCells != cells) failures++;
+
+        SaveMappedMaze(maze, path);
+        MappedMaze mapped(path);
+        if (mapped.Rows() != maze.Rows() || mapped.Columns() != maze.Columns() ||
+            !std::equal(cells.begin(), cells.end(), mapped.Cells())) {
+            failures++;
+        }
+    }
+    std::remove(path.c_str());
+    return failures;
+}
+
+// Distances (and the previous cell on a shortest path) from `from` to every cell, by BFS.
+void bfsFrom(const Maze& maze, Point from, std::vector<int>& distance, std::vector<Point>& previous) {
+    const int DX[4] = {0, 0, -1, 1};
+    const int DY[4] = {-1, 1, 0, 0};
+    distance.assign((size_t)maze.Rows() * maze.Columns(), -1);
+    previous.assign(distance.size(), from);
+    std::vector<Point> queue{from};
+    distance[(size_t)from.y * maze.Columns() + from.x] = 0;
+    for (size_t head = 0; head < queue.size(); head++) {
+        Point p = queue[head];
+        for (int d = 0; d < 4; d++) {
+            Point next{p.x + DX[d], p.y + DY[d]};
+            size_t i = (size_t)next.y * maze.Columns() + next.x;
+            if (maze.At(next.x, next.y) == WALL || distance[i] >= 0) continue;
+            distance[i] = distance[(size_t)p.y * maze.Columns() + p.x] + 1;
+            previous[i] = p;
+            queue.push_back(next);
+        }
+    }
+}
+
+// Checks MazeRoutes against BFS on random built mazes: distances to the exit, distances,
+// damage and paths between random cells, and the exit route against IsSolvable. Returns the
+// number of wrong answers.
+int checkRoutes(int trials) {
+    std::mt19937 rng(54321);
+    int failures = 0;
+    std::vector<int> distance;
+    std::vector<Point> previous;
+    Route route;
+    for (int trial = 0; trial < trials; trial++) {
+        Maze maze(std::uniform_int_distribution<int>(3, 61)(rng), std::uniform_int_distribution<int>(3, 61)(rng), rng());
+        maze.Build();
+        MazeRoutes routes(maze);
+        int columns = maze.Columns();
+
+        bfsFrom(maze, maze.Exit(), distance, previous);
+        for (int y = 0; y < maze.Rows(); y++) {
+            for (int x = 0; x < columns; x++) {
+                if (routes.DistanceToExit({x, y}) != distance[(size_t)y * columns + x]) failures++;
+            }
+        }
+        if (routes.ExitRoute(route) != maze.IsSolvable()) failures++;
+
+        std::uniform_int_distribution<int> xs(0, columns - 1);
+        std::uniform_int_distribution<int> ys(0, maze.Rows() - 1);
+        for (int query = 0; query < 20; query++) {
+            Point a{xs(rng), ys(rng)};
+            Point b{xs(rng), ys(rng)};
+            bfsFrom(maze, a, distance, previous);
+            int expected = maze.At(a.x, a.y) == WALL ? -1 : distance[(size_t)b.y * columns + b.x];
+            if (routes.Distance(a, b) != expected) failures++;
+            if (routes.FindRoute(a, b, route) != (expected >= 0)) failures++;
+            if (expected < 0) continue;
+
+            // The BFS path walked backwards from b, and the route, cell by cell.
+            int damage = 0;
+            bool same = (int)route.cells.size() == expected + 1;
+            Point p = b;
+            for (int step = expected; same && step >= 0; step--) {
+                same = route.cells[step].x == p.x && route.cells[step].y == p.y;
+                if (step > 0 && maze.At(p.x, p.y) == TRAP) damage++;
+                p = previous[(size_t)p.y * columns + p.x];
+            }
+            if (!same || route.damage != damage || routes.Damage(a, b) != damage) failures++;
+        }
+    }
+    return failures;
+}
+
+// Trap count and number of traps on the entrance-exit path of a built maze.
+void countTraps(const Maze& maze, std::vector<int>& trapCounts, std::vector<int>& pathTraps) {
+    int traps = 0;
+    for (int y = 0; y < maze.Rows(); y++) {
+        for (int x = 0; x < maze.Columns(); x++) {
+            if (maze.At(x, y) == TRAP) traps++;
+        }
+    }
+    trapCounts[traps]++;
+    pathTraps[MazeRoutes(maze).Damage(maze.Entrance(), maze.Exit())]++;
+}
+
+// The placement Build used before it placed traps constructively: treasure and 0-5 traps on
+// shuffled road cells of a fresh maze, regenerating until the maze is solvable.
+void buildByRetrying(Maze& maze, std::mt19937& rng) {
+    std::vector<Point> roads;
+    do {
+        maze.Build();
+        roads.clear();
+        for (int y = 1; y < maze.Rows() - 1; y++) {
+            for (int x = 1; x < maze.Columns() - 1; x++) {
+                CellType type = maze.At(x, y);
+                if (type == TRAP || type == TREASURE) maze.Set(x, y, ROAD);
+                if (type != ENTRANCE && type != EXIT && type != WALL) roads.push_back({x, y});
+            }
+        }
+        std::shuffle(roads.begin(), roads.end(), rng);
+        if (!roads.empty()) {
+            maze.Set(roads.back().x, roads.back().y, TREASURE);
+            roads.pop_back();
+        }
+        int trapCount = std::uniform_int_distribution<int>(0, 5)(rng);
+        for (int i = 0; i < trapCount && !roads.empty(); i++) {
+            maze.Set(roads.back().x, roads.back().y, TRAP);
+            roads.pop_back();
+        }
+    } while (!maze.IsSolvableBfs());
+}
+
+// Total variation distance between two histograms of `trials` samples each.
+double histogramDistance(const std::vector<int>& a, const std::vector<int>& b, int trials) {
+    double distance = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        distance += std::abs(a[i] - b[i]) / 2.0 / trials;
+    }
+    return distance;
+}
+
+// Builds mazes of a few sizes from many seeds: each must be solvable, and the histograms of
+// the trap count and of the traps on the path must be within MAX_DISTANCE (total variation)
+// of those of the old regenerate-until-solvable loop. Sampling noise alone is about 0.01.
+// Build draws the traps for the maze it has, while the old loop also swapped mazes, favouring
+// those with short paths when it drew many traps; that leaves Build with slightly fewer
+// traps, about 0.02 off at 101x101. Returns the number of failures.
+int checkTrapPlacement(int trials) {
+    const int SIDES[][2] = {{9, 15}, {21, 21}, {41, 61}, {101, 101}};
+    const double MAX_DISTANCE = 0.04;
+    std::mt19937 rng(2024);
+    int failures = 0;
+    for (const auto& side : SIDES) {
+        std::vector<int> trapCounts(6), pathTraps(Maze::MAX_PATH_TRAPS + 1);
+        std::vector<int> retryTrapCounts(6), retryPathTraps(Maze::MAX_PATH_TRAPS + 1);
+        Maze maze(side[0], side[1], 0);
+        for (int trial = 0; trial < trials; trial++) {
+            maze.Seed(MazeSeed(side[0] * 1000 + side[1], trial));
+            maze.Build();
+            if (!maze.IsSolvable()) failures++;
+            countTraps(maze, trapCounts, pathTraps);
+            buildByRetrying(maze, rng);
+            countTraps(maze, retryTrapCounts, retryPathTraps);
+        }
+
+        double countDistance = histogramDistance(trapCounts, retryTrapCounts, trials);
+        double pathDistance = histogramDistance(pathTraps, retryPathTraps, trials);
+        if (countDistance > MAX_DISTANCE || pathDistance > MAX_DISTANCE) failures++;
+        std::cout << "    " << maze.Rows() << "x" << maze.Columns() << ": traps 0-5";
+        for (size_t i = 0; i < trapCounts.size(); i++) std::cout << " " << trapCounts[i] << "/" << retryTrapCounts[i];
+        std::cout << ", on path 0-2";
+        for (size_t i = 0; i < pathTraps.size(); i++) std::cout << " " << pathTraps[i] << "/" << retryPathTraps[i];
+        std::cout << " (distance " << countDistance << ", " << pathDistance << ")" << std::endl;
+    }
+    return failures;
+}
+
+// Generation, solving, route, output and export timings of one square maze, and the peak RSS
+// of the process. Returns 1 if the solvers disagree.
+int benchSide(int side) {
+    Maze maze(side, side);
+    double cells = (double)maze.Rows() * maze.Columns();
+
+    auto start = std::chrono::steady_clock::now();
+    maze.GenerateMaze(1, 1);
+    auto generated = std::chrono::steady_clock::now();
+    maze.Build();
+    auto built = std::chrono::steady_clock::now();
+
+    double generateMs = std::chrono::duration<double, std::milli>(generated - start).count();
+    double buildMs = std::chrono::duration<double, std::milli>(built - generated).count();
+    std::cout << maze.Rows() << "x" << maze.Columns() << ": generate " << generateMs << " ms ("
+              << (long long)(cells / generateMs * 1000) << " cells/sec), build " << buildMs
+              << " ms, peak RSS " << getPeakMemory() / 1024 / 1024 << " MB" << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    bool bfs = maze.IsSolvableBfs();
+    auto searched = std::chrono::steady_clock::now();
+    bool bitset = maze.IsSolvable();
+    auto solved = std::chrono::steady_clock::now();
+
+    double bfsMs = std::chrono::duration<double, std::milli>(searched - start).count();
+    double bitsetMs = std::chrono::duration<double, std::milli>(solved - searched).count();
+    std::cout << "    solvable " << (bitset ? "yes" : "no") << (bfs == bitset ? "" : " (BFS disagrees)")
+              << ": BFS " << bfsMs << " ms, bitset " << bitsetMs << " ms (" << bfsMs / bitsetMs << "x)" << std::endl;
+    if (bfs != bitset) return 1;
+
+    start = std::chrono::steady_clock::now();
+    MazeRoutes routes(maze);
+    auto indexed = std::chrono::steady_clock::now();
+    Route route;
+    bool exitFound = routes.ExitRoute(route);
+    auto routed = std::chrono::steady_clock::now();
+
+    std::mt19937 rng(side);
+    std::uniform_int_distribution<int> xs(1, maze.Columns() - 2);
+    std::uniform_int_distribution<int> ys(1, maze.Rows() - 2);
+    int queries = 1000000;
+    long long checksum = 0;
+    auto queried = std::chrono::steady_clock::now();
+    for (int i = 0; i < queries; i++) {
+        checksum += routes.Distance({xs(rng), ys(rng)}, {xs(rng), ys(rng)});
+    }
+    double queryMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - queried).count();
+
+    std::cout << "    routes: index " << std::chrono::duration<double, std::milli>(indexed - start).count()
+              << " ms, exit route " << (exitFound ? route.cells.size() : 0) << " cells in "
+              << std::chrono::duration<double, std::milli>(routed - indexed).count() << " ms, "
+              << (long long)(queries / queryMs * 1000) << " distance queries/sec (checksum " << checksum
+              << "), peak RSS " << getPeakMemory() / 1024 / 1024 << " MB" << std::endl;
+
+    std::ofstream sink(NULL_DEVICE, std::ios::binary);
+    double megabytes = (double)maze.Render().size() / (1 << 20);
+    start = std::chrono::steady_clock::now();
+    printPerCell(maze, sink);
+    auto printed = std::chrono::steady_clock::now();
+    maze.Print(sink);
+    auto rendered = std::chrono::steady_clock::now();
+
+    std::vector<uint8_t> packed(maze.PackedSize());
+    maze.Pack(packed.data());
+    auto packedAt = std::chrono::steady_clock::now();
+
+    std::string path = "bench_maze.map";
+    SaveMappedMaze(maze, path);
+    auto saved = std::chrono::steady_clock::now();
+    long long cellSum = 0;
+    {
+        MappedMaze mapped(path);
+        cellSum += mapped.At(mapped.Columns() - 2, mapped.Rows() - 2);
+    }
+    auto mappedAt = std::chrono::steady_clock::now();
+    std::remove(path.c_str());
+
+    auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+    std::cout << "    output: per-cell print " << ms(start, printed) << " ms (" << megabytes / ms(start, printed) * 1000
+              << " MB/s), buffered print " << ms(printed, rendered) << " ms (" << megabytes / ms(printed, rendered) * 1000
+              << " MB/s), " << ms(start, printed) / ms(printed, rendered) << "x" << std::endl;
+    std::cout << "    export: pack " << ms(rendered, packedAt) << " ms (" << packed.size() / 1024 << " KB, "
+              << cells / packed.size() << "x smaller than a byte per cell), mapped save " << ms(packedAt, saved)
+              << " ms (" << cells / 1024 << " KB), mapped open " << ms(saved, mappedAt) << " ms (exit "
+              << (cellSum == EXIT ? "ok" : "wrong") << ")" << std::endl;
+    return 0;
+}
+
+// Usage: Task2_bench [max side]
+// Runs the checks, then generates and builds square mazes of growing size. Every size is
+// measured by its own run of the bench (Task2_bench --side N), so the peak RSS printed for it
+// is the peak of that size alone.
+int main(int argc, char** argv) {
+    if (argc > 2 && std::strcmp(argv[1], "--side") == 0) return benchSide(std::stoi(argv[2]));
+    int maxSide = argc > 1 ? std::stoi(argv[1]) : 10000;
+
+    std::vector<int> sides;
+    for (double side = 1000; side < maxSide; side *= std::sqrt(10.0)) {
+        sides.push_back((int)side);
+    }
+    sides.push_back(maxSide);
+
+    int trials = 20000;
+    int mismatches = checkSolvers(trials);
+    std::cout << "Solver check: " << mismatches << " mismatches in " << trials << " random grids" << std::endl;
+    if (mismatches > 0) return 1;
+
+    trials = 2000;
+    int failures = checkRoutes(trials);
+    std::cout << "Routes check: " << failures << " wrong answers in " << trials << " random mazes" << std::endl;
+    if (failures > 0) return 1;
+
+    trials = 20000;
+    std::cout << "Trap placement check (Build / regenerating until solvable):" << std::endl;
+    failures = checkTrapPlacement(trials);
+    std::cout << "Trap placement check: " << failures << " failures in " << trials << " mazes per size" << std::endl;
+    if (failures > 0) return 1;
+
+    trials = 500;
+    failures = checkExport(trials);
+    std::cout << "Export check: " << failures << " failures in " << trials << " random mazes" << std::endl;
+    if (failures > 0) return 1;
+
+    for (int side : sides) {
+        std::cout.flush();
+        std::string command = "\"" + std::string(argv[0]) + "\" --side " + std::to_string(side);
+        if (std::system(command.c_str()) != 0) return 1;
+    }
+    return 0;
+}
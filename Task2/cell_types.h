@@ -0,0 +1,14 @@
+#pragma once
+
+struct Point {
+    int x;
+    int y;
+};
+
+enum CellType {ENTRANCE =0,
+    EXIT = 1,
+    ROAD = 2,
+    WALL = 3,
+    TRAP = 4,
+    TREASURE = 5
+};
@@ -0,0 +1,360 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "cell_types.h"
+#include "solver.h"
+
+// Seed of maze `index` in a batch started from `baseSeed` (SplitMix64), so every maze can be
+// rebuilt on its own from the pair.
+inline uint64_t MazeSeed(uint64_t baseSeed, uint64_t index) {
+    uint64_t z = baseSeed + 0x9E3779B97F4A7C15ULL * (index + 1);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+class Maze {
+private:
+    // Each cell is one byte: the CellType in the low bits. While the maze is being generated,
+    // road cells also store the direction back to the cell they were carved from. ON_PATH marks
+    // the road cells between the entrance and the exit.
+    static constexpr uint8_t TYPE_MASK = 0x07;
+    static constexpr uint8_t HAS_PARENT = 0x20;
+    static constexpr uint8_t ON_PATH = 0x40;
+    static constexpr uint8_t PARENT_MASK = HAS_PARENT | (3 << 3);
+    static constexpr int PARENT_SHIFT = 3;
+    static constexpr int MAX_TRAPS = 5;
+
+    // Console glyph of each CellType (indices 6 and 7 are unused).
+    static constexpr char GLYPHS[8] = {'S', 'E', ' ', '#', '0', 'T', '#', '#'};
+
+    // Up, down, left, right: the opposite of direction d is d ^ 1.
+    static constexpr int DX[4] = {0, 0, -1, 1};
+    static constexpr int DY[4] = {-1, 1, 0, 0};
+
+    int rows;
+    int columns;
+    std::mt19937 rng;
+    std::vector<uint8_t> grid;
+    size_t roadCount = 0;
+    size_t pathRoadCount = 0;
+    DamageReachability reachability;
+    std::string text;
+
+    size_t Index(int x, int y) const { return (size_t)y * columns + x; }
+
+    uint8_t Type(int x, int y) const { return grid[Index(x, y)] & TYPE_MASK; }
+
+    // Picks a random road cell with (cell & pathMask) == pathBits out of `available` such
+    // cells, if there is one. Random cells are sampled until one fits, so neither the roads nor
+    // the path need a list: roads make up about half of the maze and the path a few percent of
+    // it, so a cell is found in a couple (or a few dozen) of tries.
+    bool TakeRoad(Point& p, uint8_t pathMask, uint8_t pathBits, size_t available) {
+        if (available == 0) return false;
+        std::uniform_int_distribution<int> xs(1, columns - 2);
+        std::uniform_int_distribution<int> ys(1, rows - 2);
+        uint8_t cell;
+        do {
+            p = {xs(rng), ys(rng)};
+            cell = grid[Index(p.x, p.y)];
+        } while ((cell & TYPE_MASK) != ROAD || (cell & pathMask) != pathBits);
+        roadCount--;
+        if (cell & ON_PATH) pathRoadCount--;
+        return true;
+    }
+
+    // Any road cell.
+    bool TakeRandomRoad(Point& p) { return TakeRoad(p, 0, 0, roadCount); }
+
+    // A road cell on the entrance-exit path, or off it.
+    bool TakeRandomRoad(Point& p, bool onPath) {
+        return onPath ? TakeRoad(p, ON_PATH, ON_PATH, pathRoadCount) : TakeRoad(p, ON_PATH, 0, roadCount - pathRoadCount);
+    }
+
+    // Called when generation reaches (x, y): the chain of parents back to the start is the only
+    // path between them in the finished maze, since a backtracker maze is a tree.
+    void MarkPath(int x, int y) {
+        pathRoadCount = 0;
+        while (true) {
+            grid[Index(x, y)] |= ON_PATH;
+            pathRoadCount++;
+            uint8_t cell = grid[Index(x, y)];
+            if (!(cell & HAS_PARENT)) break;
+            int back = (cell >> PARENT_SHIFT) & 3;
+            grid[Index(x + DX[back], y + DY[back])] |= ON_PATH;
+            pathRoadCount++;
+            x += 2 * DX[back];
+            y += 2 * DY[back];
+        }
+    }
+
+    static double Choose(double n, int k) {
+        if (k < 0 || n < k) return 0;
+        double result = 1;
+        for (int i = 0; i < k; i++) {
+            result = result * (n - i) / (i + 1);
+        }
+        return result;
+    }
+
+    // Index drawn with probability proportional to weights[i].
+    int Draw(const double* weights, int count) {
+        double total = 0;
+        for (int i = 0; i < count; i++) total += weights[i];
+        double r = std::uniform_real_distribution<double>(0, total)(rng);
+        for (int i = 0; i < count - 1; i++) {
+            if (r < weights[i]) return i;
+            r -= weights[i];
+        }
+        return count - 1;
+    }
+
+public:
+    // Most traps a player can step on and still get out.
+    static constexpr int MAX_PATH_TRAPS = 2;
+
+    // Rows or columns of a maze asked for with `side` of them: walls and roads alternate, so
+    // the count is odd.
+    static int OddSide(int side) { return side % 2 == 0 ? side + 1 : side; }
+
+    // PackedSize of a maze built with these arguments, without building it.
+    static size_t PackedSize(int r, int c) { return ((size_t)OddSide(r) * OddSide(c) + 1) / 2; }
+
+    Maze(int r, int c, uint64_t seed = (uint64_t)std::time(0)) : rows(OddSide(r)), columns(OddSide(c)) {
+        grid.assign((size_t)rows * columns, WALL);
+
+        Seed(seed);
+    }
+
+    // The same seed always builds the same maze, so one Maze can be reused for many of them.
+    void Seed(uint64_t seed) {
+        std::seed_seq sequence{(uint32_t)seed, (uint32_t)(seed >> 32)};
+        rng.seed(sequence);
+    }
+
+    int Rows() const { return rows; }
+
+    int Columns() const { return columns; }
+
+    Point Entrance() const { return {1, 1}; }
+
+    Point Exit() const { return {columns - 2, rows - 2}; }
+
+    CellType At(int x, int y) const { return (CellType)Type(x, y); }
+
+    void Set(int x, int y, CellType type) { grid[Index(x, y)] = type; }
+
+    // Recursive backtracker without recursion. Every step carves into a random uncarved
+    // neighbour two cells away, or walks back to the parent cell when there is none. The way
+    // back is stored in the cells themselves, so no stack grows with the path length and the
+    // grid is the only memory used.
+    void GenerateMaze(int cx, int cy) {
+        grid[Index(cx, cy)] = ROAD;
+        roadCount = 1;
+        pathRoadCount = 0;
+        if (cx == columns - 2 && cy == rows - 2) MarkPath(cx, cy);
+
+        int x = cx;
+        int y = cy;
+        while (true) {
+            int options[4];
+            int count = 0;
+            for (int d = 0; d < 4; d++) {
+                int new_x = x + 2 * DX[d];
+                int new_y = y + 2 * DY[d];
+                if (new_y > 0 && new_y < rows - 1 && new_x > 0 && new_x < columns - 1 && Type(new_x, new_y) == WALL) {
+                    options[count++] = d;
+                }
+            }
+
+            if (count > 0) {
+                int d = options[count == 1 ? 0 : std::uniform_int_distribution<int>(0, count - 1)(rng)];
+                grid[Index(x + DX[d], y + DY[d])] = ROAD;
+                x += 2 * DX[d];
+                y += 2 * DY[d];
+                grid[Index(x, y)] = ROAD | HAS_PARENT | ((d ^ 1) << PARENT_SHIFT);
+                roadCount += 2;
+                if (x == columns - 2 && y == rows - 2) MarkPath(x, y);
+                continue;
+            }
+
+            uint8_t& cell = grid[Index(x, y)];
+            if (!(cell & HAS_PARENT)) break;
+            int back = (cell >> PARENT_SHIFT) & 3;
+            cell &= ~PARENT_MASK;
+            x += 2 * DX[back];
+            y += 2 * DY[back];
+        }
+    }
+
+    // Places the treasure and 0-5 traps on random road cells. A backtracker maze is a tree, so
+    // the maze is solvable exactly when at most MAX_PATH_TRAPS traps are on the one path from
+    // the entrance to the exit (marked during generation). Instead of placing traps blindly and
+    // regenerating until the maze is solvable, the trap count and the number of traps on the
+    // path are drawn from the distribution that regenerating would give for this maze, then
+    // the traps are placed uniformly on and off the path. Generation must start at (1, 1).
+    void PlaceObjects() {
+        pathRoadCount -= 2;
+        grid[Index(1, 1)] = ENTRANCE;
+        roadCount--;
+
+        if (Type(columns - 2, rows - 2) == ROAD) {
+            grid[Index(columns - 2, rows - 2)] = EXIT;
+            roadCount--;
+        } else {
+            // Entrance and exit are the same cell.
+            grid[Index(columns - 2, rows - 2)] = EXIT;
+            pathRoadCount = 0;
+        }
+
+        Point p;
+        if (TakeRandomRoad(p)) {
+            grid[Index(p.x, p.y)] = TREASURE;
+        }
+
+        // P(trap count k) is proportional to P(at most MAX_PATH_TRAPS of k traps are on the
+        // path), and P(j traps on the path | k) to the hypergeometric probability of j.
+        double roads = (double)roadCount;
+        double pathRoads = (double)pathRoadCount;
+        double countWeights[MAX_TRAPS + 1];
+        double pathWeights[MAX_TRAPS + 1][MAX_PATH_TRAPS + 1];
+        for (int k = 0; k <= MAX_TRAPS; k++) {
+            int placed = (int)std::min<double>(k, roads);
+            countWeights[k] = 0;
+            for (int j = 0; j <= MAX_PATH_TRAPS; j++) {
+                pathWeights[k][j] = Choose(pathRoads, j) * Choose(roads - pathRoads, placed - j) / Choose(roads, placed);
+                countWeights[k] += pathWeights[k][j];
+            }
+        }
+        int trapCount = Draw(countWeights, MAX_TRAPS + 1);
+        int pathTraps = Draw(pathWeights[trapCount], MAX_PATH_TRAPS + 1);
+
+        for (int i = 0; i < trapCount; i++) {
+            bool placed = TakeRandomRoad(p, i < pathTraps);
+            if (!placed) break;
+
+            grid[Index(p.x, p.y)] = TRAP;
+        }
+    }
+
+    void Build() {
+        std::fill(grid.begin(), grid.end(), WALL);
+
+        GenerateMaze(1, 1);
+
+        PlaceObjects();
+    }
+
+    // Size of Pack's output: one 4-bit CellType per cell.
+    size_t PackedSize() const { return (grid.size() + 1) / 2; }
+
+    // Cell types, row by row, two cells per byte (the first one in the low nibble).
+    void Pack(uint8_t* out) const {
+        size_t pairs = grid.size() / 2;
+        for (size_t i = 0; i < pairs; i++) {
+            out[i] = (uint8_t)((grid[2 * i] & TYPE_MASK) | ((grid[2 * i + 1] & TYPE_MASK) << 4));
+        }
+        if (grid.size() % 2) out[pairs] = grid.back() & TYPE_MASK;
+    }
+
+    // One CellType per byte, row by row.
+    void CopyTypes(uint8_t* out) const {
+        for (size_t i = 0; i < grid.size(); i++) {
+            out[i] = grid[i] & TYPE_MASK;
+        }
+    }
+
+    // Reads cells written by Pack for a maze of this size. False if `size` is not PackedSize()
+    // or a cell is not a CellType.
+    bool Unpack(const uint8_t* data, size_t size) {
+        if (size != PackedSize()) return false;
+        for (size_t i = 0; i < grid.size(); i++) {
+            uint8_t type = (data[i / 2] >> (i % 2 * 4)) & 0x0f;
+            if (type > TREASURE) return false;
+            grid[i] = type;
+        }
+        return true;
+    }
+
+    // The console picture of the maze: a glyph and a space per cell, a newline per row. The
+    // text is kept between calls, so only the glyphs are rewritten.
+    const std::string& Render() {
+        size_t width = 2 * (size_t)columns + 1;
+        if (text.size() != width * rows) {
+            text.assign(width * rows, ' ');
+            for (int y = 0; y < rows; y++) {
+                text[width * (y + 1) - 1] = '\n';
+            }
+        }
+        char* out = text.data();
+        const uint8_t* cell = grid.data();
+        for (int y = 0; y < rows; y++) {
+            for (int x = 0; x < columns; x++) {
+                out[2 * x] = GLYPHS[cell[x] & TYPE_MASK];
+            }
+            out += width;
+            cell += columns;
+        }
+        return text;
+    }
+
+    void Print(std::ostream& out = std::cout) {
+        const std::string& picture = Render();
+        out.write(picture.data(), (std::streamsize)picture.size());
+        out.flush();
+    }
+
+    // True when the exit can be reached from the entrance stepping on at most MAX_PATH_TRAPS
+    // traps, checked on row bitsets (see DamageReachability).
+    bool IsSolvable() {
+        return reachability.Reachable(grid.data(), TYPE_MASK, rows, columns, Entrance(), Exit(), MAX_PATH_TRAPS);
+    }
+
+    // The same check as a breadth-first search over (cell, damage) states. Kept as the
+    // reference IsSolvable is tested against.
+    bool IsSolvableBfs() const {
+        struct State {
+            int x, y, damage;
+        };
+
+        std::queue<State> states;
+        states.push({1,1,0});
+
+        std::vector<bool> visited(grid.size() * (MAX_PATH_TRAPS + 1), false);
+        visited[Index(1, 1)] = true;
+
+        while (!states.empty()) {
+            State current = states.front();
+            states.pop();
+
+            if (Type(current.x, current.y) == EXIT) {
+                return true;
+            }
+
+            for (int i = 0; i < 4; i++) {
+                int new_x = current.x + DX[i];
+                int new_y = current.y + DY[i];
+
+                if (new_x >= 0 && new_x < columns && new_y >= 0 && new_y < rows && Type(new_x, new_y) != WALL) {
+                    int receivedDamage = current.damage + (Type(new_x, new_y) == TRAP ? 1 : 0);
+                    size_t state = receivedDamage * grid.size() + Index(new_x, new_y);
+                    if (receivedDamage <= MAX_PATH_TRAPS && !visited[state]) {
+                        visited[state] = true;
+                        states.push({new_x, new_y, receivedDamage});
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+};
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+    #include <iterator>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "maze.h"
+
+// Maze files: this header, then the cells. A mapped file (MAZEMAP1) holds one CellType per
+// byte, row by row, so a client can map it and read cells in place. A packed file (MAZEPAK1)
+// holds Maze::Pack's output, two cells per byte, `size` bytes.
+struct MazeFileHeader {
+    char magic[8];
+    uint32_t rows;
+    uint32_t columns;
+    uint64_t size;
+    uint64_t reserved;
+};
+
+inline constexpr char MAZE_MAP_MAGIC[8] = {'M', 'A', 'Z', 'E', 'M', 'A', 'P', '1'};
+inline constexpr char MAZE_PACKED_MAGIC[8] = {'M', 'A', 'Z', 'E', 'P', 'A', 'K', '1'};
+
+inline void WriteMazeFile(const std::string& path, const char* magic, const Maze& maze, const std::vector<uint8_t>& cells) {
+    MazeFileHeader header{};
+    std::memcpy(header.magic, magic, sizeof(header.magic));
+    header.rows = (uint32_t)maze.Rows();
+    header.columns = (uint32_t)maze.Columns();
+    header.size = cells.size();
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) throw std::runtime_error("Cannot open " + path);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(cells.data()), (std::streamsize)cells.size());
+    if (!out.flush()) throw std::runtime_error("Cannot write " + path);
+}
+
+inline void SaveMappedMaze(const Maze& maze, const std::string& path) {
+    std::vector<uint8_t> cells((size_t)maze.Rows() * maze.Columns());
+    maze.CopyTypes(cells.data());
+    WriteMazeFile(path, MAZE_MAP_MAGIC, maze, cells);
+}
+
+inline void SavePackedMaze(const Maze& maze, const std::string& path) {
+    std::vector<uint8_t> cells(maze.PackedSize());
+    maze.Pack(cells.data());
+    WriteMazeFile(path, MAZE_PACKED_MAGIC, maze, cells);
+}
+
+inline Maze LoadPackedMaze(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) throw std::runtime_error("Cannot open " + path);
+    MazeFileHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, MAZE_PACKED_MAGIC, sizeof(header.magic)) != 0) {
+        throw std::runtime_error("Not a packed maze: " + path);
+    }
+    std::vector<uint8_t> cells(header.size);
+    in.read(reinterpret_cast<char*>(cells.data()), (std::streamsize)cells.size());
+
+    Maze maze((int)header.rows, (int)header.columns, 0);
+    if (!in || maze.Rows() != (int)header.rows || maze.Columns() != (int)header.columns ||
+        !maze.Unpack(cells.data(), cells.size())) {
+        throw std::runtime_error("Not a packed maze: " + path);
+    }
+    return maze;
+}
+
+// A mapped maze file, read in place.
+class MappedMaze {
+private:
+    const uint8_t* cells = nullptr;
+    int rows = 0;
+    int columns = 0;
+#ifdef _WIN32
+    std::vector<char> data;
+#else
+    void* mapping = MAP_FAILED;
+    size_t mappingSize = 0;
+#endif
+
+    void Load(const char* base, size_t size, const std::string& path) {
+        MazeFileHeader header;
+        if (size < sizeof(header)) throw std::runtime_error("Not a mapped maze: " + path);
+        std::memcpy(&header, base, sizeof(header));
+        if (std::memcmp(header.magic, MAZE_MAP_MAGIC, sizeof(header.magic)) != 0 ||
+            header.size != (uint64_t)header.rows * header.columns || size - sizeof(header) < header.size) {
+            throw std::runtime_error("Not a mapped maze: " + path);
+        }
+        cells = reinterpret_cast<const uint8_t*>(base + sizeof(header));
+        rows = (int)header.rows;
+        columns = (int)header.columns;
+    }
+
+public:
+    explicit MappedMaze(const std::string& path) {
+#ifdef _WIN32
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open()) throw std::runtime_error("Cannot open " + path);
+        data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        Load(data.data(), data.size(), path);
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Cannot open " + path);
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            close(fd);
+            throw std::runtime_error("Not a mapped maze: " + path);
+        }
+        mappingSize = (size_t)st.st_size;
+        mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED) throw std::runtime_error("Cannot map " + path);
+        try {
+            Load(static_cast<const char*>(mapping), mappingSize, path);
+        } catch (...) {
+            munmap(mapping, mappingSize);
+            throw;
+        }
+#endif
+    }
+
+    ~MappedMaze() {
+#ifndef _WIN32
+        if (mapping != MAP_FAILED) munmap(mapping, mappingSize);
+#endif
+    }
+
+    MappedMaze(const MappedMaze&) = delete;
+    MappedMaze& operator=(const MappedMaze&) = delete;
+
+    int Rows() const { return rows; }
+
+    int Columns() const { return columns; }
+
+    CellType At(int x, int y) const { return (CellType)cells[(size_t)y * columns + x]; }
+
+    // The cells, one CellType per byte, row by row.
+    const uint8_t* Cells() const { return cells; }
+};
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "maze.h"
+
+// A path through the maze, both ends included, and the damage taken walking it.
+struct Route {
+    std::vector<Point> cells;
+    int damage = 0;
+};
+
+// Path queries over a built maze. A backtracker maze is a tree, so the path between two cells
+// is unique: it climbs from both ends to their lowest common ancestor in the tree rooted at
+// the exit. Built once in O(N * M), after which
+//   - distance to the exit is a lookup,
+//   - distance and damage between any two cells take O(log(N * M)),
+//   - a path is listed in O(path length).
+// Ancestors are found with jump pointers (Myers' skew-binary scheme): each cell keeps one
+// jump to an ancestor, chosen so that any ancestor is reached in O(log depth) jumps, which
+// costs one word per cell instead of the log(N * M) words of binary lifting. The parent is
+// not stored at all, it is the one open neighbour one step closer to the exit.
+// The maze must be a tree, as Build makes it (Set can open loops), and must not change while
+// its MazeRoutes is in use.
+class MazeRoutes {
+private:
+    static constexpr uint32_t UNREACHABLE = std::numeric_limits<uint32_t>::max();
+
+    static constexpr int DX[4] = {0, 0, -1, 1};
+    static constexpr int DY[4] = {-1, 1, 0, 0};
+
+    const Maze& maze;
+    int columns;
+    std::vector<uint32_t> depth;
+    std::vector<uint32_t> jump;
+    // Traps on the way from the cell to the exit, the cell itself included.
+    std::vector<uint16_t> traps;
+    Point treasure{-1, -1};
+
+    size_t Index(Point p) const { return (size_t)p.y * columns + p.x; }
+
+    Point At(size_t i) const { return {(int)(i % columns), (int)(i / columns)}; }
+
+    bool Inside(Point p) const { return p.x >= 0 && p.x < columns && p.y >= 0 && p.y < maze.Rows(); }
+
+    bool IsTrap(size_t i) const { return maze.At((int)(i % columns), (int)(i / columns)) == TRAP; }
+
+    size_t Parent(size_t i) const {
+        Point p = At(i);
+        for (int d = 0; d < 4; d++) {
+            Point next{p.x + DX[d], p.y + DY[d]};
+            if (Inside(next) && depth[Index(next)] + 1 == depth[i]) return Index(next);
+        }
+        return i;
+    }
+
+    size_t Ancestor(size_t i, uint32_t targetDepth) const {
+        while (depth[i] > targetDepth) {
+            i = depth[jump[i]] >= targetDepth ? jump[i] : Parent(i);
+        }
+        return i;
+    }
+
+    // Both cells must be reachable.
+    size_t Lca(size_t a, size_t b) const {
+        a = Ancestor(a, depth[b]);
+        b = Ancestor(b, depth[a]);
+        // Jumps depend only on the depth, so two cells at the same depth jump the same way.
+        while (a != b) {
+            if (jump[a] != jump[b]) {
+                a = jump[a];
+                b = jump[b];
+            } else {
+                a = Parent(a);
+                b = Parent(b);
+            }
+        }
+        return a;
+    }
+
+    // Traps stepped on walking from `a` to `b` (the cell walked from does not count).
+    int Damage(size_t a, size_t b, size_t lca) const {
+        return traps[a] + traps[b] - 2 * traps[lca] + (IsTrap(lca) ? 1 : 0) - (IsTrap(a) ? 1 : 0);
+    }
+
+    void AppendPath(size_t a, size_t b, std::vector<Point>& cells) const {
+        size_t lca = Lca(a, b);
+        for (size_t i = a; i != lca; i = Parent(i)) {
+            cells.push_back(At(i));
+        }
+        size_t middle = cells.size();
+        for (size_t i = b; i != lca; i = Parent(i)) {
+            cells.push_back(At(i));
+        }
+        cells.push_back(At(lca));
+        std::reverse(cells.begin() + middle, cells.end());
+    }
+
+public:
+    // Breadth-first search from the exit. A cell is found after its parent, so its jump can
+    // be set right away from the parent's.
+    explicit MazeRoutes(const Maze& m) : maze(m), columns(m.Columns()) {
+        size_t cells = (size_t)maze.Rows() * columns;
+        depth.assign(cells, UNREACHABLE);
+        jump.assign(cells, 0);
+        traps.assign(cells, 0);
+
+        for (int y = 0; y < maze.Rows(); y++) {
+            for (int x = 0; x < columns; x++) {
+                if (maze.At(x, y) == TREASURE) treasure = {x, y};
+            }
+        }
+
+        size_t root = Index(maze.Exit());
+        depth[root] = 0;
+        jump[root] = (uint32_t)root;
+        traps[root] = IsTrap(root) ? 1 : 0;
+
+        std::vector<uint32_t> queue{(uint32_t)root};
+        for (size_t head = 0; head < queue.size(); head++) {
+            size_t parent = queue[head];
+            Point p = At(parent);
+            for (int d = 0; d < 4; d++) {
+                Point next{p.x + DX[d], p.y + DY[d]};
+                if (!Inside(next) || maze.At(next.x, next.y) == WALL) continue;
+                size_t i = Index(next);
+                if (depth[i] != UNREACHABLE) continue;
+
+                depth[i] = depth[parent] + 1;
+                uint32_t up = jump[parent];
+                bool sameStride = depth[parent] - depth[up] == depth[up] - depth[jump[up]];
+                jump[i] = sameStride ? jump[up] : (uint32_t)parent;
+                traps[i] = (uint16_t)(traps[parent] + (IsTrap(i) ? 1 : 0));
+                queue.push_back((uint32_t)i);
+            }
+        }
+    }
+
+    // Steps from `p` to the exit, -1 when the exit cannot be reached from it.
+    int DistanceToExit(Point p) const {
+        if (!Inside(p) || depth[Index(p)] == UNREACHABLE) return -1;
+        return (int)depth[Index(p)];
+    }
+
+    // Steps between `a` and `b`, -1 when there is no path.
+    int Distance(Point a, Point b) const {
+        if (DistanceToExit(a) < 0 || DistanceToExit(b) < 0) return -1;
+        size_t lca = Lca(Index(a), Index(b));
+        return (int)(depth[Index(a)] + depth[Index(b)] - 2 * depth[lca]);
+    }
+
+    // Traps stepped on walking from `a` to `b`, -1 when there is no path.
+    int Damage(Point a, Point b) const {
+        if (DistanceToExit(a) < 0 || DistanceToExit(b) < 0) return -1;
+        return Damage(Index(a), Index(b), Lca(Index(a), Index(b)));
+    }
+
+    // The path from `a` to `b`. False when there is none.
+    bool FindRoute(Point a, Point b, Route& route) const {
+        route.cells.clear();
+        route.damage = 0;
+        if (DistanceToExit(a) < 0 || DistanceToExit(b) < 0) return false;
+        AppendPath(Index(a), Index(b), route.cells);
+        route.damage = Damage(a, b);
+        return true;
+    }
+
+    // The shortest path from the entrance to the exit, if it takes at most `maxDamage` damage.
+    bool ExitRoute(Route& route, int maxDamage = Maze::MAX_PATH_TRAPS) const {
+        return FindRoute(maze.Entrance(), maze.Exit(), route) && route.damage <= maxDamage;
+    }
+
+    // The shortest path from the entrance through the treasure to the exit, if the maze has a
+    // treasure and the path takes at most `maxDamage` damage. Traps on the part walked twice
+    // hit twice.
+    bool TreasureRoute(Route& route, int maxDamage = Maze::MAX_PATH_TRAPS) const {
+        route.cells.clear();
+        route.damage = 0;
+        if (DistanceToExit(treasure) < 0 || DistanceToExit(maze.Entrance()) < 0) return false;
+
+        size_t entrance = Index(maze.Entrance());
+        size_t middle = Index(treasure);
+        size_t exit = Index(maze.Exit());
+        AppendPath(entrance, middle, route.cells);
+        route.cells.pop_back();
+        AppendPath(middle, exit, route.cells);
+        route.damage = Damage(entrance, middle, Lca(entrance, middle)) + Damage(middle, exit, exit);
+        return route.damage <= maxDamage;
+    }
+};
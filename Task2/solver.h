@@ -0,0 +1,180 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "cell_types.h"
+
+// Reachability under a damage limit on 64-bit row bitsets. Bit i of word w of a row is column
+// 64 * w + i. Cells reachable with at most d damage are grown layer by layer: layer d + 1 adds
+// the traps next to layer d and then floods the trap-free cells from everything reached so
+// far. A flood step works on one word at a time: the word takes in its neighbours above,
+// below and across the word edges, then spreads along the row with shift/and operations
+// (log2(64) steps each way), and a word that changed queues only the neighbours it can spread
+// into.
+class DamageReachability {
+private:
+    int rows = 0;
+    int words = 0;
+    std::vector<uint64_t> passable;
+    std::vector<uint64_t> traps;
+    std::vector<uint64_t> reached;
+    std::vector<uint32_t> pending;
+    std::vector<uint8_t> queued;
+    std::vector<std::pair<uint32_t, uint64_t>> stepped;
+
+    static constexpr uint64_t ONES = 0x0101010101010101ULL;
+    static constexpr uint64_t LOW_SEVEN = 0x7F7F7F7F7F7F7F7FULL;
+
+    // One bit per byte of `bytes` (the first byte in bit 0), set where the byte equals `value`.
+    static uint64_t BytesEqual(uint64_t bytes, uint8_t value) {
+        uint64_t x = bytes ^ (value * ONES);
+        uint64_t zero = ~(((x & LOW_SEVEN) + LOW_SEVEN) | x | LOW_SEVEN);
+        return ((zero >> 7) * 0x0102040810204080ULL) >> 56;
+    }
+
+    size_t Word(int y, int w) const { return (size_t)y * words + w; }
+
+    void Push(int y, int w) {
+        if (y < 0 || y >= rows || w < 0 || w >= words) return;
+        size_t i = Word(y, w);
+        if (queued[i]) return;
+        queued[i] = 1;
+        pending.push_back((uint32_t)i);
+    }
+
+    // Queues a word whose bits were set outside Flood, along with the words around it.
+    void Touch(int y, int w) {
+        Push(y, w);
+        Push(y - 1, w);
+        Push(y + 1, w);
+        Push(y, w - 1);
+        Push(y, w + 1);
+    }
+
+    // Bits of `from` spread one cell in every direction within the row bitsets.
+    uint64_t Dilate(const std::vector<uint64_t>& from, int y, int w) const {
+        size_t i = Word(y, w);
+        uint64_t x = from[i];
+        uint64_t result = x | (x << 1) | (x >> 1);
+        if (w > 0) result |= from[i - 1] >> 63;
+        if (w + 1 < words) result |= from[i + 1] << 63;
+        if (y > 0) result |= from[i - words];
+        if (y + 1 < rows) result |= from[i + words];
+        return result;
+    }
+
+    // Everything reachable from `x` along the row through set bits of `open`.
+    static uint64_t FillRow(uint64_t x, uint64_t open) {
+        uint64_t left = x, leftOpen = open;
+        uint64_t right = x, rightOpen = open;
+        for (int shift = 1; shift < 64; shift *= 2) {
+            left |= leftOpen & (left << shift);
+            leftOpen &= leftOpen << shift;
+            right |= rightOpen & (right >> shift);
+            rightOpen &= rightOpen >> shift;
+        }
+        return left | right;
+    }
+
+    // Floods the trap-free cells from the pending words. Returns true once `target` is reached.
+    bool Flood(size_t target, uint64_t targetBit) {
+        while (!pending.empty()) {
+            size_t i = pending.back();
+            pending.pop_back();
+            queued[i] = 0;
+
+            int y = (int)(i / words);
+            int w = (int)(i % words);
+            uint64_t old = reached[i];
+            uint64_t x = FillRow(old | (Dilate(reached, y, w) & passable[i]), passable[i]);
+            if (x == old) continue;
+
+            reached[i] = x;
+            if (i == target && (x & targetBit)) return true;
+
+            // Only neighbours with an open, unreached cell next to a new bit have work to do.
+            uint64_t added = x & ~old;
+            if (y > 0 && (added & passable[i - words] & ~reached[i - words])) Push(y - 1, w);
+            if (y + 1 < rows && (added & passable[i + words] & ~reached[i + words])) Push(y + 1, w);
+            if (w > 0 && (added & 1) && ((passable[i - 1] & ~reached[i - 1]) >> 63)) Push(y, w - 1);
+            if (w + 1 < words && (added >> 63) && (passable[i + 1] & ~reached[i + 1] & 1)) Push(y, w + 1);
+        }
+        return false;
+    }
+
+public:
+    // True when `to` can be reached from `from` stepping on at most `maxDamage` traps. `cells`
+    // holds one CellType per byte (under `typeMask`), row by row.
+    bool Reachable(const uint8_t* cells, uint8_t typeMask, int r, int columns, Point from, Point to, int maxDamage) {
+        rows = r;
+        words = (columns + 63) / 64;
+        size_t total = (size_t)rows * words;
+        passable.assign(total, 0);
+        traps.assign(total, 0);
+        reached.assign(total, 0);
+        queued.assign(total, 0);
+        pending.clear();
+
+        uint64_t typeBytes = typeMask * ONES;
+        for (int y = 0; y < rows; y++) {
+            const uint8_t* row = cells + (size_t)y * columns;
+            for (int w = 0; w < words; w++) {
+                int begin = w * 64;
+                int count = columns - begin < 64 ? columns - begin : 64;
+                uint64_t blocked = 0, trap = 0;
+                int b = 0;
+                for (; b + 8 <= count; b += 8) {
+                    uint64_t bytes;
+                    std::memcpy(&bytes, row + begin + b, 8);
+                    bytes &= typeBytes;
+                    uint64_t traps8 = BytesEqual(bytes, TRAP);
+                    blocked |= (BytesEqual(bytes, WALL) | traps8) << b;
+                    trap |= traps8 << b;
+                }
+                for (; b < count; b++) {
+                    uint8_t type = row[begin + b] & typeMask;
+                    blocked |= (uint64_t)(type == WALL || type == TRAP) << b;
+                    trap |= (uint64_t)(type == TRAP) << b;
+                }
+                uint64_t inside = count == 64 ? ~0ULL : (1ULL << count) - 1;
+                passable[Word(y, w)] = ~blocked & inside;
+                traps[Word(y, w)] = trap;
+            }
+        }
+
+        size_t target = Word(to.y, to.x / 64);
+        uint64_t targetBit = 1ULL << (to.x % 64);
+        reached[Word(from.y, from.x / 64)] = 1ULL << (from.x % 64);
+        if (from.x == to.x && from.y == to.y) return true;
+        Touch(from.y, from.x / 64);
+
+        for (int damage = 0; damage <= maxDamage; damage++) {
+            if (damage > 0) {
+                // One more trap: every trap next to a reached cell. All of them are found
+                // before any is added, so a trap does not count as reached for its neighbours
+                // in the same layer.
+                stepped.clear();
+                for (int y = 0; y < rows; y++) {
+                    for (int w = 0; w < words; w++) {
+                        size_t i = Word(y, w);
+                        uint64_t bits = traps[i] & ~reached[i] & Dilate(reached, y, w);
+                        if (bits) stepped.push_back({(uint32_t)i, bits});
+                    }
+                }
+                for (const auto& [i, bits] : stepped) {
+                    reached[i] |= bits;
+                }
+                if (reached[target] & targetBit) return true;
+                for (const auto& [i, bits] : stepped) {
+                    Touch((int)(i / words), (int)(i % words));
+                }
+            }
+            if (Flood(target, targetBit)) return true;
+        }
+        return false;
+    }
+};
@@ -0,0 +1,398 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "block.h"
+#include "mempool.h"
+#include "packages.h"
+#include "synthetic.h"
+#include "transactions.h"
+#include "tx_store.h"
+
+const int MB = 1000000;
+
+std::vector<Transaction> parseCsv(const std::string& csv) {
+    std::vector<Transaction> txs;
+    size_t header_end = csv.find('\n') + 1;
+    parseRows(csv.data() + header_end, csv.data() + csv.size(), txs);
+    return txs;
+}
+
+// The density-ordered greedy pass restricted to valid blocks: a transaction is only taken
+// once all of its parents are in the block.
+long long validGreedyFee(const std::vector<Transaction>& txs, const MempoolGraph& graph, int max_capacity) {
+    std::vector<uint32_t> order(txs.size());
+    for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return txs[a].density > txs[b].density; });
+
+    std::vector<uint8_t> included(txs.size(), 0);
+    long long size = 0, fee = 0;
+    for (uint32_t tx : order) {
+        bool ready = true;
+        for (uint32_t k = graph.parent_offsets[tx]; k < graph.parent_offsets[tx + 1]; k++) {
+            ready = ready && included[graph.parents[k]];
+        }
+        if (ready && size + txs[tx].size <= max_capacity) {
+            included[tx] = 1;
+            size += txs[tx].size;
+            fee += txs[tx].fee;
+        }
+    }
+    return fee;
+}
+
+// True when every transaction of the block comes after its parents and the block fits.
+bool isValidBlock(const BlockResult& block, const std::vector<Transaction>& txs, const MempoolGraph& graph, int max_capacity) {
+    std::unordered_map<std::string_view, uint32_t> index;
+    for (uint32_t i = 0; i < txs.size(); i++) index.emplace(txs[i].id, i);
+
+    std::vector<uint8_t> included(txs.size(), 0);
+    long long size = 0;
+    for (std::string_view id : block.tx_ids) {
+        uint32_t tx = index.at(id);
+        for (uint32_t k = graph.parent_offsets[tx]; k < graph.parent_offsets[tx + 1]; k++) {
+            if (!included[graph.parents[k]]) return false;
+        }
+        if (included[tx]) return false;
+        included[tx] = 1;
+        size += txs[tx].size;
+    }
+    return size == block.total_size && size <= max_capacity;
+}
+
+// Ancestor-feerate selection without any bookkeeping: every round rescores every package from
+// scratch. O(N^2) and more, only for checking constructPackageBlock on small mempools.
+std::vector<std::string_view> naivePackageBlock(const std::vector<Transaction>& txs, const MempoolGraph& graph, int max_capacity) {
+    size_t count = txs.size();
+    std::vector<uint8_t> included(count, 0);
+    std::vector<std::string_view> ids;
+    long long size = 0;
+
+    auto packageOf = [&](uint32_t tx) {
+        std::vector<uint32_t> members, stack{tx};
+        std::vector<uint8_t> seen(count, 0);
+        while (!stack.empty()) {
+            uint32_t v = stack.back();
+            stack.pop_back();
+            if (included[v] || seen[v]) continue;
+            seen[v] = 1;
+            members.push_back(v);
+            for (uint32_t k = graph.parent_offsets[v]; k < graph.parent_offsets[v + 1]; k++) stack.push_back(graph.parents[k]);
+        }
+        return members;
+    };
+
+    while (true) {
+        long long best_fee = 0, best_size = 1;
+        int best = -1;
+        for (uint32_t tx = 0; tx < count; tx++) {
+            if (included[tx]) continue;
+            long long fee = 0, package_size = 0;
+            for (uint32_t v : packageOf(tx)) {
+                fee += txs[v].fee;
+                package_size += txs[v].size;
+            }
+            if (size + package_size > max_capacity) continue;
+            double score = (double)fee / package_size;
+            double best_score = (double)best_fee / best_size;
+            if (best < 0 || score > best_score) {
+                best = (int)tx;
+                best_fee = fee;
+                best_size = package_size;
+            }
+        }
+        if (best < 0) break;
+
+        // Parents first: a member goes in once none of its parents is left outside.
+        std::vector<uint32_t> members = packageOf((uint32_t)best);
+        std::sort(members.begin(), members.end());
+        while (!members.empty()) {
+            for (size_t m = 0; m < members.size(); m++) {
+                uint32_t v = members[m];
+                bool ready = true;
+                for (uint32_t k = graph.parent_offsets[v]; k < graph.parent_offsets[v + 1]; k++) {
+                    ready = ready && included[graph.parents[k]];
+                }
+                if (!ready) continue;
+                included[v] = 1;
+                ids.push_back(txs[v].id);
+                size += txs[v].size;
+                members.erase(members.begin() + m);
+                break;
+            }
+        }
+    }
+    return ids;
+}
+
+// Compares the fee of constructPackageBlock with the naive selection on small random
+// mempools, and checks that every block it builds is valid. Returns the number of failures.
+int checkPackages(int trials) {
+    int failures = 0;
+    for (int trial = 0; trial < trials; trial++) {
+        MempoolShape shape;
+        shape.count = 5 + trial % 60;
+        shape.seed = 1000 + trial;
+        shape.child_share = 0.6;
+        shape.parent_window = 8;
+        std::ostringstream csv;
+        writeMempoolCsv(csv, shape);
+        std::string text = csv.str();
+        std::vector<Transaction> txs = parseCsv(text);
+        MempoolGraph graph = buildGraph(txs);
+
+        int capacity = 2000 + trial * 37 % 8000;
+        BlockResult block = constructPackageBlock(txs, graph, capacity);
+        std::vector<std::string_view> expected = naivePackageBlock(txs, graph, capacity);
+        long long expected_fee = 0;
+        std::unordered_map<std::string_view, long long> fees;
+        for (const auto& tx : txs) fees[tx.id] = tx.fee;
+        for (std::string_view id : expected) expected_fee += fees[id];
+
+        if (!isValidBlock(block, txs, graph, capacity) || block.total_fee != expected_fee) failures++;
+    }
+    return failures;
+}
+
+double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Keeps a pool of `pool` independent transactions under a stream of arrivals and evictions
+// (one of each per step), asking for a template every `template_every` steps. Each template
+// comes from the incremental Mempool, and is timed against constructBlock over a copy of the
+// pool (rebuilding from scratch) and checked against a plain greedy pass.
+bool streamingBenchmark(size_t pool, size_t steps, size_t template_every) {
+    MempoolShape shape;
+    shape.count = pool + steps;
+    shape.seed = 7;
+    shape.child_share = 0;
+    std::ostringstream csv;
+    writeMempoolCsv(csv, shape);
+    std::string text = csv.str();
+    std::vector<Transaction> stream = parseCsv(text);
+
+    Mempool mempool;
+    std::vector<uint32_t> live;
+    for (uint32_t i = 0; i < pool; i++) {
+        mempool.addTx(stream[i].id, stream[i].size, stream[i].fee);
+        live.push_back(i);
+    }
+
+    std::mt19937 rng(11);
+    const size_t MAX_MISSES = 1000;
+    double update_ms = 0, template_ms = 0, rebuild_ms = 0, bounded_ms = 0;
+    long long template_fee = 0, bounded_fee = 0;
+    size_t templates = 0;
+    for (size_t step = 0; step < steps; step++) {
+        auto start = std::chrono::steady_clock::now();
+        uint32_t arriving = (uint32_t)(pool + step);
+        mempool.addTx(stream[arriving].id, stream[arriving].size, stream[arriving].fee);
+        live.push_back(arriving);
+        size_t leaving = std::uniform_int_distribution<size_t>(0, live.size() - 1)(rng);
+        mempool.removeTx(stream[live[leaving]].id);
+        live[leaving] = live.back();
+        live.pop_back();
+        update_ms += msSince(start);
+
+        if (step % template_every != 0) continue;
+        BlockResult incremental = mempool.buildTemplate(MB);
+        template_ms += incremental.duration_ms;
+        template_fee += incremental.total_fee;
+        BlockResult bounded = mempool.buildTemplate(MB, MAX_MISSES);
+        bounded_ms += bounded.duration_ms;
+        bounded_fee += bounded.total_fee;
+
+        // In arrival order, so constructBlock breaks density ties as the mempool does.
+        std::sort(live.begin(), live.end());
+        std::vector<Transaction> copy;
+        copy.reserve(live.size());
+        for (uint32_t i : live) copy.push_back(stream[i]);
+        BlockResult rebuilt = constructBlock(copy, MB);
+        rebuild_ms += rebuilt.duration_ms;
+        templates++;
+
+        if (incremental.tx_ids != rebuilt.tx_ids) {
+            std::cout << "Incremental template differs from the greedy pass at step " << step << std::endl;
+            return false;
+        }
+    }
+
+    std::cout << "Streaming mempool of " << pool << " transactions, " << steps << " arrivals and evictions: "
+              << update_ms * 1e6 / (2 * steps) << " ns per update" << std::endl;
+    std::cout << "    " << templates << " templates: incremental " << template_ms / templates << " ms each, rebuilt with sort "
+              << rebuild_ms / templates << " ms each (" << rebuild_ms / template_ms << "x)" << std::endl;
+    std::cout << "    stopping after " << MAX_MISSES << " misses in a row: " << bounded_ms / templates << " ms each, "
+              << (double)(template_fee - bounded_fee) / templates << " satoshis less fee each (of "
+              << template_fee / (long long)templates << ")" << std::endl;
+    return true;
+}
+
+// Checks TailKnapsack against dynamic programming over the capacity on small random
+// instances, with enough time to finish. Returns the number of wrong answers.
+int checkTailKnapsack(int trials) {
+    std::mt19937 rng(99);
+    int failures = 0;
+    for (int trial = 0; trial < trials; trial++) {
+        std::vector<Transaction> items(std::uniform_int_distribution<int>(1, 24)(rng));
+        for (auto& item : items) {
+            item.size = std::uniform_int_distribution<int>(100, 1500)(rng);
+            item.fee = std::uniform_int_distribution<long long>(100, 20000)(rng);
+            item.density = (double)item.fee / item.size;
+        }
+        std::sort(items.begin(), items.end(), [](const Transaction& a, const Transaction& b) { return a.density > b.density; });
+        int space = std::uniform_int_distribution<int>(0, 8000)(rng);
+
+        std::vector<long long> best(space + 1, 0);
+        for (const auto& item : items) {
+            for (int s = space; s >= item.size; s--) best[s] = std::max(best[s], best[s - item.size] + item.fee);
+        }
+
+        std::vector<uint8_t> none(items.size(), 0);
+        TailKnapsack knapsack(items, none);
+        const std::vector<uint8_t>& taken = knapsack.solve(space, 1000);
+        long long fee = 0, size = 0;
+        for (size_t i = 0; i < items.size(); i++) {
+            if (!taken[i]) continue;
+            fee += items[i].fee;
+            size += items[i].size;
+        }
+        if (fee != best[space] || size > space) failures++;
+    }
+    return failures;
+}
+
+// Fee the tail fill adds to the greedy block for a range of time budgets, averaged over
+// several synthetic mempools.
+void tailBenchmark(size_t count, int mempools) {
+    const double budgets[] = {0.1, 0.5, 1, 2, 5, 10};
+    std::vector<std::vector<Transaction>> pools;
+    std::vector<std::string> texts(mempools);
+    for (int m = 0; m < mempools; m++) {
+        MempoolShape shape;
+        shape.count = count;
+        shape.seed = 100 + m;
+        shape.child_share = 0;
+        std::ostringstream csv;
+        writeMempoolCsv(csv, shape);
+        texts[m] = csv.str();
+        pools.push_back(parseCsv(texts[m]));
+    }
+
+    std::cout << "Tail fill over " << mempools << " mempools of " << count << " transactions:" << std::endl;
+    for (double budget : budgets) {
+        double gain = 0, percent = 0, spent = 0, free_bytes = 0;
+        for (const auto& pool : pools) {
+            std::vector<Transaction> copy = pool;
+            BlockResult block = constructBlock(copy, MB, budget);
+            gain += block.tail_fee_gain;
+            percent += (double)block.tail_fee_gain / (block.total_fee - block.tail_fee_gain) * 100;
+            spent += block.tail_ms;
+            free_bytes += MB - block.total_size;
+        }
+        std::cout << "    budget " << budget << " ms: +" << gain / mempools << " satoshis (+" << percent / mempools
+                  << "%), " << spent / mempools << " ms spent, " << free_bytes / mempools << " bytes left" << std::endl;
+    }
+}
+
+// constructBlock against selectBlock on a TransactionStore, for `count` independent
+// transactions built in memory (log-normal sizes and feerates, short hex IDs). Both must
+// pick the same transactions.
+bool storeBenchmark(size_t count) {
+    std::mt19937_64 rng(count);
+    std::lognormal_distribution<double> sizes(std::log(300.0), 0.9);
+    std::lognormal_distribution<double> feerates(std::log(5.0), 1.3);
+    std::string id_text(count * 8, '0');
+    std::vector<Transaction> txs(count);
+    for (size_t i = 0; i < count; i++) {
+        char id[9];
+        std::snprintf(id, sizeof(id), "%08x", (unsigned)i);
+        std::memcpy(&id_text[i * 8], id, 8);
+        int size = (int)std::clamp(sizes(rng), 100.0, 100000.0);
+        long long fee = std::max(1LL, std::llround(size * feerates(rng)));
+        txs[i] = {std::string_view(id_text).substr(i * 8, 8), size, fee, (double)fee / size, {}};
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    TransactionStore store(txs);
+    double store_ms = msSince(start);
+    BlockResult selected = selectBlock(store, MB);
+
+    std::vector<Transaction> copy = txs;
+    BlockResult sorted = constructBlock(copy, MB);
+
+    std::sort(selected.tx_ids.begin(), selected.tx_ids.end());
+    std::sort(sorted.tx_ids.begin(), sorted.tx_ids.end());
+    double end_to_end_ms = store_ms + selected.duration_ms;
+    std::cout << count << " transactions: constructBlock " << sorted.duration_ms << " ms, selectBlock "
+              << selected.duration_ms << " ms (" << sorted.duration_ms / selected.duration_ms << "x), store build + selectBlock "
+              << end_to_end_ms << " ms (" << sorted.duration_ms / end_to_end_ms << "x), fee " << selected.total_fee << std::endl;
+    if (selected.tx_ids != sorted.tx_ids) {
+        std::cout << "selectBlock picked different transactions" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Usage: Task5_bench [transactions]
+int main(int argc, char** argv) {
+    int trials = 500;
+    int failures = checkPackages(trials);
+    std::cout << "Package check: " << failures << " failures in " << trials << " random mempools" << std::endl;
+    if (failures > 0) return 1;
+
+    failures = checkTailKnapsack(trials);
+    std::cout << "Tail knapsack check: " << failures << " wrong answers in " << trials << " random instances" << std::endl;
+    if (failures > 0) return 1;
+
+    MempoolShape shape;
+    if (argc > 1) shape.count = std::stoul(argv[1]);
+    std::ostringstream csv;
+    writeMempoolCsv(csv, shape);
+    std::string text = csv.str();
+    std::vector<Transaction> txs = parseCsv(text);
+
+    auto start = std::chrono::steady_clock::now();
+    MempoolGraph graph = buildGraph(txs);
+    double graph_ms = msSince(start);
+
+    std::vector<Transaction> sorted = txs;
+    BlockResult greedy = constructBlock(sorted, MB);
+    bool greedy_valid = isValidBlock(greedy, txs, graph, MB);
+
+    start = std::chrono::steady_clock::now();
+    long long valid_greedy_fee = validGreedyFee(txs, graph, MB);
+    double valid_greedy_ms = msSince(start);
+
+    BlockResult packages = constructPackageBlock(txs, graph, MB);
+    if (!isValidBlock(packages, txs, graph, MB)) {
+        std::cout << "Package block is not valid" << std::endl;
+        return 1;
+    }
+
+    std::cout << txs.size() << " transactions, " << graph.parents.size() << " parent links (graph built in "
+              << graph_ms << " ms)" << std::endl;
+    std::cout << "Greedy by density:        fee " << greedy.total_fee << " in " << greedy.duration_ms << " ms"
+              << (greedy_valid ? "" : " (not a valid block: children before parents)") << std::endl;
+    std::cout << "Greedy, parents first:    fee " << valid_greedy_fee << " in " << valid_greedy_ms << " ms" << std::endl;
+    std::cout << "Ancestor packages (CPFP): fee " << packages.total_fee << " in " << packages.duration_ms << " ms, "
+              << packages.tx_ids.size() << " transactions, " << packages.total_size << " bytes ("
+              << (double)(packages.total_fee - valid_greedy_fee) / valid_greedy_fee * 100 << "% over valid greedy)" << std::endl;
+
+    if (!streamingBenchmark(shape.count, 200000, 2000)) return 1;
+
+    tailBenchmark(shape.count, 5);
+
+    for (size_t count : {100000, 1000000, 10000000}) {
+        if (!storeBenchmark(count)) return 1;
+    }
+    return 0;
+}
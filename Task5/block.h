@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+#include "tail_fill.h"
+#include "transactions.h"
+
+struct BlockResult {
+    std::vector<std::string_view> tx_ids;
+    int total_size;
+    long long total_fee;
+    double duration_ms;
+    size_t peak_memory;
+    double load_ms = 0;
+    size_t rows_loaded = 0;
+    size_t rows_skipped = 0;       // malformed rows left out by the loader
+    long long tail_fee_gain = 0;   // fee added by the tail fill, included in total_fee
+    double tail_ms = 0;            // 0 when the tail fill did not run
+    double graph_ms = 0;           // parent graph build, included in duration_ms; 0 without parents
+    double store_ms = 0;           // TransactionStore build for selectBlock, included in duration_ms
+};
+
+inline size_t getPeakMemory() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS info;
+    GetProcessMemoryInfo(GetCurrentProcess(), &info, sizeof(info));
+    return (size_t)info.PeakWorkingSetSize;
+#else
+    struct rusage r_usage;
+    getrusage(RUSAGE_SELF, &r_usage);
+    return (size_t)(r_usage.ru_maxrss * 1024);
+#endif
+}
+
+// Densest first; density ties keep their file order, as in selectBlock and the mempool, so
+// every path picks the same block.
+inline void sortByDensity(std::vector<Transaction>& txs) {
+    std::stable_sort(txs.begin(), txs.end(), [](const Transaction& a, const Transaction& b) {
+        return a.density > b.density;
+    });
+}
+
+// The greedy pass over transactions already sorted by density: the indices of those that
+// still fit, in order.
+inline std::vector<uint32_t> pickGreedy(const std::vector<Transaction>& txs, int max_capacity) {
+    std::vector<uint32_t> picked;
+    int current_size = 0;
+
+    for (uint32_t i = 0; i < txs.size(); i++) {
+        if (current_size + txs[i].size <= max_capacity) {
+            picked.push_back(i);
+            current_size += txs[i].size;
+        }
+    }
+    return picked;
+}
+
+// Greedy selection by density. With a `tail_budget_ms`, the end of the block is then
+// repacked by fillTail within that time.
+inline BlockResult constructBlock(std::vector<Transaction>& txs, int max_capacity, double tail_budget_ms = 0) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    sortByDensity(txs);
+    std::vector<uint32_t> picked = pickGreedy(txs, max_capacity);
+
+    long long tail_gain = 0;
+    double tail_ms = 0;
+    if (tail_budget_ms > 0) {
+        auto tail_start = std::chrono::high_resolution_clock::now();
+        tail_gain = fillTail(txs, picked, max_capacity, tail_budget_ms);
+        tail_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tail_start).count();
+    }
+
+    std::vector<std::string_view> selected_ids;
+    selected_ids.reserve(picked.size());
+    int current_size = 0;
+    long long current_fee = 0;
+    for (uint32_t i : picked) {
+        selected_ids.push_back(txs[i].id);
+        current_size += txs[i].size;
+        current_fee += txs[i].fee;
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    BlockResult result{
+        selected_ids,
+        current_size,
+        current_fee,
+        std::chrono::duration<double, std::milli>(end - start).count(),
+        getPeakMemory()
+    };
+    result.tail_fee_gain = tail_gain;
+    result.tail_ms = tail_ms;
+    return result;
+}
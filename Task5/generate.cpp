@@ -0,0 +1,57 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "synthetic.h"
+
+// Usage: Task5_generate [count] [--seed N] [--children SHARE] [--parent-window N] [--fee-sigma X] [--out FILE]
+// Writes a synthetic mempool (synthetic.h) to FILE, transactions.csv by default. The same
+// arguments always give the same file; --children 0 gives a mempool without parent links.
+int main(int argc, char** argv) {
+    MempoolShape shape;
+    std::string filename = "transactions.csv";
+    try {
+        for (int i = 1; i < argc; i++) {
+            bool has_value = i + 1 < argc;
+            if (std::strcmp(argv[i], "--seed") == 0 && has_value) {
+                shape.seed = std::stoull(argv[++i]);
+            } else if (std::strcmp(argv[i], "--children") == 0 && has_value) {
+                shape.child_share = std::stod(argv[++i]);
+            } else if (std::strcmp(argv[i], "--parent-window") == 0 && has_value) {
+                shape.parent_window = std::max(1, std::stoi(argv[++i]));
+            } else if (std::strcmp(argv[i], "--fee-sigma") == 0 && has_value) {
+                shape.fee_sigma = std::stod(argv[++i]);
+            } else if (std::strcmp(argv[i], "--out") == 0 && has_value) {
+                filename = argv[++i];
+            } else {
+                shape.count = std::stoull(argv[i]);
+            }
+        }
+    } catch (const std::exception&) {
+        std::cerr << "Usage: Task5_generate [count] [--seed N] [--children SHARE] [--parent-window N] "
+                     "[--fee-sigma X] [--out FILE]" << std::endl;
+        return 1;
+    }
+
+    // Rows are streamed out, so the count is only limited by the disk.
+    std::vector<char> buffer(1 << 20);
+    std::ofstream out;
+    out.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    out.open(filename, std::ios::binary);
+    if (!out) {
+        std::cerr << "Cannot open " << filename << " for writing." << std::endl;
+        return 1;
+    }
+
+    writeMempoolCsv(out, shape);
+    out.close();
+    if (!out) {
+        std::cerr << "Failed to write " << filename << "." << std::endl;
+        return 1;
+    }
+    std::cout << "Wrote " << shape.count << " transactions to " << filename << std::endl;
+    return 0;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Binary max-heap of item indices [0, capacity) whose keys may change while they are in the
+// heap. Each item's position is tracked, so a changed item is moved up or down in
+// O(log N) instead of the heap being rebuilt. `Better(a, b)` is true when item a should come
+// out before item b.
+template <class Better>
+class IndexedHeap {
+private:
+    static constexpr uint32_t NOT_IN_HEAP = UINT32_MAX;
+
+    std::vector<uint32_t> heap;
+    std::vector<uint32_t> position;
+    Better better;
+
+    void place(size_t slot, uint32_t item) {
+        heap[slot] = item;
+        position[item] = (uint32_t)slot;
+    }
+
+    void siftUp(size_t slot) {
+        uint32_t item = heap[slot];
+        while (slot > 0) {
+            size_t parent = (slot - 1) / 2;
+            if (!better(item, heap[parent])) break;
+            place(slot, heap[parent]);
+            slot = parent;
+        }
+        place(slot, item);
+    }
+
+    void siftDown(size_t slot) {
+        uint32_t item = heap[slot];
+        while (true) {
+            size_t child = 2 * slot + 1;
+            if (child >= heap.size()) break;
+            if (child + 1 < heap.size() && better(heap[child + 1], heap[child])) child++;
+            if (!better(heap[child], item)) break;
+            place(slot, heap[child]);
+            slot = child;
+        }
+        place(slot, item);
+    }
+
+public:
+    explicit IndexedHeap(size_t capacity, Better b = Better()) : position(capacity, NOT_IN_HEAP), better(std::move(b)) {}
+
+    // Makes the heap hold exactly `items`, in O(N).
+    void assign(std::vector<uint32_t> items) {
+        for (uint32_t item : heap) {
+            position[item] = NOT_IN_HEAP;
+        }
+        heap = std::move(items);
+        for (size_t slot = 0; slot < heap.size(); slot++) {
+            position[heap[slot]] = (uint32_t)slot;
+        }
+        for (size_t slot = heap.size() / 2; slot-- > 0;) {
+            siftDown(slot);
+        }
+    }
+
+    bool empty() const { return heap.empty(); }
+
+    size_t size() const { return heap.size(); }
+
+    bool contains(uint32_t item) const { return position[item] != NOT_IN_HEAP; }
+
+    uint32_t top() const { return heap.front(); }
+
+    void push(uint32_t item) {
+        heap.push_back(item);
+        siftUp(heap.size() - 1);
+    }
+
+    void pop() { erase(heap.front()); }
+
+    void erase(uint32_t item) {
+        size_t slot = position[item];
+        position[item] = NOT_IN_HEAP;
+        uint32_t last = heap.back();
+        heap.pop_back();
+        if (last == item) return;
+        place(slot, last);
+        update(last);
+    }
+
+    // Restores the order after the key of `item` changed in either direction.
+    void update(uint32_t item) {
+        size_t slot = position[item];
+        siftUp(slot);
+        siftDown(position[item]);
+    }
+};
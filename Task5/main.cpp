@@ -1,118 +1,112 @@
 #include <iostream>
 #include <vector>
 #include <string>
-#include <fstream>
-#include <sstream>
+#include <string_view>
+#include <cstring>
 #include <algorithm>
 #include <chrono>
 #include <iomanip>
+#include <memory>
+#include <thread>
 
-#ifdef _WIN32
-    #include <windows.h>
-    #include <psapi.h>
-#else
-    #include <sys/resource.h>
-#endif
-
-struct Transaction {
-    std::string id;
-    int size;
-    long long fee;
-    double density;
-};
-
-struct BlockResult {
-    std::vector<std::string> tx_ids;
-    int total_size;
-    long long total_fee;
-    double duration_ms;
-    size_t peak_memory;
-};
-
-size_t getPeakMemory() {
-#ifdef _WIN32
-    PROCESS_MEMORY_COUNTERS info;
-    GetProcessMemoryInfo(GetCurrentProcess(), &info, sizeof(info));
-    return (size_t)info.PeakWorkingSetSize;
-#else
-    struct rusage r_usage;
-    getrusage(RUSAGE_SELF, &r_usage);
-    return (size_t)(r_usage.ru_maxrss * 1024);
-#endif
-}
-
-std::vector<Transaction> loadTransactions(const std::string& filename) {
-    std::vector<Transaction> txs;
-    std::ifstream file(filename);
-    if (!file.is_open()) return txs;
-
-    std::string line, header;
-    std::getline(file, header);
-
-    while (std::getline(file, line)) {
-        if (line.empty()) continue;
-        std::stringstream ss(line);
-        std::string id, s_size, s_fee;
-
-        if (std::getline(ss, id, ',') && std::getline(ss, s_size, ',') && std::getline(ss, s_fee, ',')) {
-            int size = std::stoi(s_size);
-            long long fee = std::stoll(s_fee);
-            txs.push_back({id, size, fee, (double)fee / size});
-        }
-    }
-    return txs;
-}
-
-BlockResult constructBlock(std::vector<Transaction>& txs, int max_capacity) {
-    auto start = std::chrono::high_resolution_clock::now();
-
-    std::sort(txs.begin(), txs.end(), [](const Transaction& a, const Transaction& b) {
-        return a.density > b.density;
-    });
-
-    std::vector<std::string> selected_ids;
-    int current_size = 0;
-    long long current_fee = 0;
-
-    for (const auto& tx : txs) {
-        if (current_size + tx.size <= max_capacity) {
-            selected_ids.push_back(tx.id);
-            current_size += tx.size;
-            current_fee += tx.fee;
-        }
-    }
-
-    auto end = std::chrono::high_resolution_clock::now();
-
-    return {
-        selected_ids,
-        current_size,
-        current_fee,
-        std::chrono::duration<double, std::milli>(end - start).count(),
-        getPeakMemory()
-    };
-}
+#include "block.h"
+#include "packages.h"
+#include "transactions.h"
+#include "tx_store.h"
 
 void printReport(const BlockResult& res) {
     std::cout << "BITCOIN BLOCK CONSTRUCTION REPORT" << std::endl;
+    std::cout << "Rows Loaded: " << res.rows_loaded << " in " << std::fixed << std::setprecision(4) << res.load_ms
+              << " ms (" << std::setprecision(0) << res.rows_loaded / (res.load_ms / 1000) << " rows/sec)" << std::endl;
+    if (res.rows_skipped > 0) {
+        std::cout << "Malformed Rows Skipped: " << res.rows_skipped << std::endl;
+    }
     std::cout << "Transactions in block: " << res.tx_ids.size() << std::endl;
     std::cout << "Total Block Size: " << res.total_size << " / 1000000 bytes" << std::endl;
     std::cout << "Total Fee Extracted: " << res.total_fee << " satoshis" << std::endl;
+    if (res.tail_ms > 0) {
+        std::cout << "Tail Fill Gain: +" << res.tail_fee_gain << " satoshis in " << std::fixed << std::setprecision(4)
+                  << res.tail_ms << " ms" << std::endl;
+    }
     std::cout << "Construction  Time: " << std::fixed << std::setprecision(4) << res.duration_ms << " ms" << std::endl;
+    if (res.graph_ms > 0) {
+        std::cout << "  of which Parent Graph Build: " << std::fixed << std::setprecision(4) << res.graph_ms << " ms" << std::endl;
+    }
+    if (res.store_ms > 0) {
+        std::cout << "  of which Store Build: " << std::fixed << std::setprecision(4) << res.store_ms << " ms" << std::endl;
+    }
     std::cout << "Peak Memory Usage: " << res.peak_memory / 1024 / 1024 << " MB" << std::endl;
 }
 
-int main() {
+// Usage: Task5 [transactions.csv] [--threads N] [--tail-budget MS]
+int main(int argc, char** argv) {
     const int MB = 1000000;
 
-    std::vector<Transaction> transactions = loadTransactions("transactions.csv");
+    std::string filename = "transactions.csv";
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    double tail_budget_ms = 0;
+    try {
+        for (int i = 1; i < argc; i++) {
+            if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+                threads = std::max(1ul, std::stoul(argv[++i]));
+            } else if (std::strcmp(argv[i], "--tail-budget") == 0 && i + 1 < argc) {
+                tail_budget_ms = std::stod(argv[++i]);
+            } else {
+                filename = argv[i];
+            }
+        }
+    } catch (const std::exception&) {
+        std::cerr << "Usage: Task5 [transactions.csv] [--threads N] [--tail-budget MS]" << std::endl;
+        return 1;
+    }
+
+    // The transaction IDs point into the file, so it stays mapped until the report is printed.
+    std::unique_ptr<MappedFile> file;
+    try {
+        file = std::make_unique<MappedFile>(filename);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    auto load_start = std::chrono::high_resolution_clock::now();
+    size_t skipped_rows = 0;
+    std::vector<Transaction> transactions = loadTransactions(*file, threads, &skipped_rows);
+    auto load_end = std::chrono::high_resolution_clock::now();
     if (transactions.empty()) {
         std::cerr << "No data found or file error." << std::endl;
         return 1;
     }
 
-    BlockResult result = constructBlock(transactions, MB);
+    // With parent links a transaction is only valid after its parents, so the block is built
+    // from ancestor packages. Without them only the densest part of the mempool is sorted,
+    // unless the tail fill needs the full order.
+    BlockResult result;
+    if (hasParents(transactions)) {
+        if (tail_budget_ms > 0) {
+            std::cerr << "Warning: --tail-budget is ignored, the transactions have parents and the block is built "
+                         "from ancestor packages." << std::endl;
+        }
+        auto graph_start = std::chrono::high_resolution_clock::now();
+        MempoolGraph graph = buildGraph(transactions);
+        double graph_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - graph_start).count();
+        result = constructPackageBlock(transactions, graph, MB);
+        result.graph_ms = graph_ms;
+        result.duration_ms += graph_ms;
+    } else if (tail_budget_ms > 0) {
+        result = constructBlock(transactions, MB, tail_budget_ms);
+    } else {
+        auto store_start = std::chrono::high_resolution_clock::now();
+        TransactionStore store(transactions);
+        double store_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - store_start).count();
+        result = selectBlock(store, MB);
+        result.store_ms = store_ms;
+        result.duration_ms += store_ms;
+    }
+    result.load_ms = std::chrono::duration<double, std::milli>(load_end - load_start).count();
+    result.rows_loaded = transactions.size();
+    result.rows_skipped = skipped_rows;
 
     printReport(result);
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#ifdef _WIN32
+    #include <fstream>
+    #include <iterator>
+    #include <vector>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+// A whole file mapped read-only (read into memory on Windows). Views into it stay valid for
+// the lifetime of the object.
+class MappedFile {
+private:
+    const char* bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    std::vector<char> data;
+#else
+    void* mapping = MAP_FAILED;
+#endif
+
+public:
+    explicit MappedFile(const std::string& filename) {
+#ifdef _WIN32
+        std::ifstream in(filename, std::ios::binary);
+        if (!in.is_open()) throw std::runtime_error("Cannot open " + filename);
+        data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        bytes = data.data();
+        length = data.size();
+#else
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Cannot open " + filename);
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            throw std::runtime_error("Cannot open " + filename);
+        }
+        length = (size_t)st.st_size;
+        if (length > 0) {
+            mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        close(fd);
+        if (length > 0) {
+            if (mapping == MAP_FAILED) throw std::runtime_error("Cannot map " + filename);
+            madvise(mapping, length, MADV_WILLNEED);
+            bytes = static_cast<const char*>(mapping);
+        }
+#endif
+    }
+
+    ~MappedFile() {
+#ifndef _WIN32
+        if (mapping != MAP_FAILED) munmap(mapping, length);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::string_view view() const { return {bytes, length}; }
+};
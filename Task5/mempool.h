@@ -0,0 +1,110 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "block.h"
+
+// A long-lived mempool that keeps its transactions ordered by density as they arrive and
+// leave, so a block template is a walk from the densest transaction instead of a sort of the
+// whole pool. Adding or removing a transaction costs O(log N). A template costs O(B) for the
+// B transactions it looks at: the walk stops as soon as the space left is below the smallest
+// transaction in the pool. That is not bounded by the block: once the block is nearly full,
+// every transaction larger than the space left is passed over, so with one small transaction
+// near the bottom of the pool the walk covers all N. buildTemplate can also stop after a
+// number of consecutive misses, as Bitcoin Core's miner does, trading a little fee for a walk
+// proportional to the block. Transactions are taken as independent, like constructBlock
+// (parent links are handled by constructPackageBlock).
+class Mempool {
+private:
+    struct Entry {
+        double density;
+        uint64_t sequence;   // arrival order, breaks density ties
+        int size;
+        long long fee;
+        const std::string* id;
+    };
+
+    struct DenserFirst {
+        bool operator()(const Entry& a, const Entry& b) const {
+            return a.density > b.density || (a.density == b.density && a.sequence < b.sequence);
+        }
+    };
+
+    // Looks up std::string keys by std::string_view without building a string.
+    struct IdHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view id) const { return std::hash<std::string_view>()(id); }
+    };
+
+    std::set<Entry, DenserFirst> by_density;
+    std::unordered_map<std::string, std::set<Entry, DenserFirst>::iterator, IdHash, std::equal_to<>> by_id;
+    std::map<int, size_t> size_counts;
+    uint64_t next_sequence = 0;
+
+public:
+    // False if a transaction with this ID is already in the pool or the size is not positive.
+    bool addTx(std::string_view id, int size, long long fee) {
+        if (size <= 0) return false;
+        auto [slot, inserted] = by_id.try_emplace(std::string(id));
+        if (!inserted) return false;
+        slot->second = by_density.insert({(double)fee / size, next_sequence++, size, fee, &slot->first}).first;
+        size_counts[size]++;
+        return true;
+    }
+
+    // False if there is no transaction with this ID.
+    bool removeTx(std::string_view id) {
+        auto slot = by_id.find(id);
+        if (slot == by_id.end()) return false;
+        int size = slot->second->size;
+        by_density.erase(slot->second);
+        by_id.erase(slot);
+        auto count = size_counts.find(size);
+        if (--count->second == 0) size_counts.erase(count);
+        return true;
+    }
+
+    size_t size() const { return by_id.size(); }
+
+    // The block constructBlock would build from the transactions in the pool, or with
+    // `max_misses`, the part of it found before that many transactions in a row did not fit.
+    // The IDs stay valid until those transactions are removed.
+    BlockResult buildTemplate(int max_capacity, size_t max_misses = SIZE_MAX) const {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        std::vector<std::string_view> selected_ids;
+        int current_size = 0;
+        long long current_fee = 0;
+        int smallest = size_counts.empty() ? 0 : size_counts.begin()->first;
+        size_t misses = 0;
+
+        for (auto it = by_density.begin(); it != by_density.end() && current_size + smallest <= max_capacity; ++it) {
+            if (current_size + it->size <= max_capacity) {
+                selected_ids.push_back(*it->id);
+                current_size += it->size;
+                current_fee += it->fee;
+                misses = 0;
+            } else if (++misses >= max_misses) {
+                break;
+            }
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+
+        return {
+            selected_ids,
+            current_size,
+            current_fee,
+            std::chrono::duration<double, std::milli>(end - start).count(),
+            getPeakMemory()
+        };
+    }
+};
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "block.h"
+#include "indexed_heap.h"
+#include "transactions.h"
+
+// Block construction by ancestor feerate (child-pays-for-parent). A transaction can only go
+// into the block together with its ancestors still outside it, so each one is scored by the
+// feerate of that package: its fee and size plus those of its unconfirmed ancestors. The
+// best package is taken whole, parents first. Every transaction included is then taken out
+// of the package of each of its descendants, whose scores are updated in place in a mutable
+// heap rather than re-sorting. A package that does not fit is dropped, and comes back if one
+// of its ancestors is included later and it becomes smaller.
+//
+// Cost: O((N + D) log N) for N transactions, where D is the total size of the ancestor and
+// descendant sets visited (linear when chains are bounded in length, as mempool policy does).
+inline BlockResult constructPackageBlock(const std::vector<Transaction>& txs, const MempoolGraph& graph, int max_capacity) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    size_t count = txs.size();
+    std::vector<long long> package_fee(count);
+    std::vector<long long> package_size(count);
+    std::vector<double> score(count);
+    std::vector<uint8_t> included(count, 0);
+    std::vector<uint32_t> seen(count, UINT32_MAX);
+    std::vector<uint32_t> stack;
+
+    // Adds every ancestor of `tx` (not yet included) to its package, counting shared
+    // ancestors once.
+    for (uint32_t tx = 0; tx < count; tx++) {
+        package_fee[tx] = txs[tx].fee;
+        package_size[tx] = txs[tx].size;
+        stack.assign(graph.parents.begin() + graph.parent_offsets[tx], graph.parents.begin() + graph.parent_offsets[tx + 1]);
+        while (!stack.empty()) {
+            uint32_t ancestor = stack.back();
+            stack.pop_back();
+            if (seen[ancestor] == tx) continue;
+            seen[ancestor] = tx;
+            package_fee[tx] += txs[ancestor].fee;
+            package_size[tx] += txs[ancestor].size;
+            for (uint32_t k = graph.parent_offsets[ancestor]; k < graph.parent_offsets[ancestor + 1]; k++) {
+                stack.push_back(graph.parents[k]);
+            }
+        }
+        score[tx] = (double)package_fee[tx] / package_size[tx];
+    }
+
+    auto better = [&](uint32_t a, uint32_t b) { return score[a] > score[b] || (score[a] == score[b] && a < b); };
+    IndexedHeap<decltype(better)> heap(count, better);
+    std::vector<uint32_t> all(count);
+    for (uint32_t tx = 0; tx < count; tx++) {
+        all[tx] = tx;
+    }
+    heap.assign(std::move(all));
+
+    std::vector<std::string_view> selected_ids;
+    long long current_size = 0;
+    long long current_fee = 0;
+    std::vector<uint32_t> package;
+    std::vector<std::pair<uint32_t, uint32_t>> walk;
+    std::vector<uint32_t> descendants;
+    std::fill(seen.begin(), seen.end(), UINT32_MAX);
+    uint32_t round = 0;
+
+    // Nothing fits once the space left is below the smallest transaction.
+    long long smallest = LLONG_MAX;
+    for (const auto& tx : txs) {
+        smallest = std::min<long long>(smallest, tx.size);
+    }
+
+    while (!heap.empty() && current_size + smallest <= max_capacity) {
+        uint32_t best = heap.top();
+        if (current_size + package_size[best] > max_capacity) {
+            heap.pop();
+            continue;
+        }
+
+        // The package in topological order: a post-order walk over the parents that are not
+        // in the block yet.
+        round++;
+        package.clear();
+        walk.assign(1, {best, graph.parent_offsets[best]});
+        seen[best] = round;
+        while (!walk.empty()) {
+            auto& [tx, next] = walk.back();
+            if (next == graph.parent_offsets[tx + 1]) {
+                package.push_back(tx);
+                walk.pop_back();
+                continue;
+            }
+            uint32_t parent = graph.parents[next++];
+            if (included[parent] || seen[parent] == round) continue;
+            seen[parent] = round;
+            walk.push_back({parent, graph.parent_offsets[parent]});
+        }
+
+        for (uint32_t tx : package) {
+            included[tx] = 1;
+            if (heap.contains(tx)) heap.erase(tx);
+            selected_ids.push_back(txs[tx].id);
+            current_size += txs[tx].size;
+            current_fee += txs[tx].fee;
+        }
+
+        // Each transaction leaves the packages of all of its descendants.
+        for (uint32_t tx : package) {
+            round++;
+            descendants.assign(graph.children.begin() + graph.child_offsets[tx], graph.children.begin() + graph.child_offsets[tx + 1]);
+            while (!descendants.empty()) {
+                uint32_t descendant = descendants.back();
+                descendants.pop_back();
+                if (seen[descendant] == round) continue;
+                seen[descendant] = round;
+
+                // Package members are already in the block, but their descendants are not.
+                if (!included[descendant]) {
+                    package_fee[descendant] -= txs[tx].fee;
+                    package_size[descendant] -= txs[tx].size;
+                    score[descendant] = (double)package_fee[descendant] / package_size[descendant];
+                    if (heap.contains(descendant)) {
+                        heap.update(descendant);
+                    } else {
+                        heap.push(descendant);
+                    }
+                }
+                for (uint32_t k = graph.child_offsets[descendant]; k < graph.child_offsets[descendant + 1]; k++) {
+                    descendants.push_back(graph.children[k]);
+                }
+            }
+        }
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    return {
+        selected_ids,
+        (int)current_size,
+        current_fee,
+        std::chrono::duration<double, std::milli>(end - start).count(),
+        getPeakMemory()
+    };
+}
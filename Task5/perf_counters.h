@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+struct CounterValues {
+    bool valid = false;
+    uint64_t cycles = 0;
+    uint64_t cache_misses = 0;
+    uint64_t branch_misses = 0;
+};
+
+// Hardware counters for the calling thread (user space only) through perf_event_open, read
+// as one group so the three values cover the same interval. Not available off Linux, or when
+// the kernel does not allow it (perf_event_paranoid, containers, VMs without a PMU); then
+// stop() returns values with valid == false.
+class PerfCounters {
+private:
+    static constexpr int EVENTS = 3;
+    int fds[EVENTS] = {-1, -1, -1};
+
+#ifdef __linux__
+    static int open(uint64_t config, int group) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = config;
+        attr.disabled = group == -1 ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+    }
+#endif
+
+    void close() {
+#ifdef __linux__
+        for (int& fd : fds) {
+            if (fd >= 0) ::close(fd);
+            fd = -1;
+        }
+#endif
+    }
+
+public:
+    PerfCounters() {
+#ifdef __linux__
+        const uint64_t configs[EVENTS] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+        for (int i = 0; i < EVENTS; i++) {
+            fds[i] = open(configs[i], fds[0]);
+            if (fds[i] < 0) {
+                close();
+                return;
+            }
+        }
+#endif
+    }
+
+    ~PerfCounters() { close(); }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const { return fds[0] >= 0; }
+
+    void start() {
+#ifdef __linux__
+        if (!available()) return;
+        ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    CounterValues stop() {
+        CounterValues values;
+#ifdef __linux__
+        if (!available()) return values;
+        ioctl(fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        uint64_t data[1 + EVENTS];   // number of events, then one value per event
+        if (read(fds[0], data, sizeof(data)) != (ssize_t)sizeof(data) || data[0] != EVENTS) return values;
+        values.valid = true;
+        values.cycles = data[1];
+        values.cache_misses = data[2];
+        values.branch_misses = data[3];
+#endif
+        return values;
+    }
+};
@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "block.h"
+#include "packages.h"
+#include "perf_counters.h"
+#include "transactions.h"
+#include "tx_store.h"
+
+const int MB = 1000000;
+
+// Everything measured for one stage, one entry per trial.
+struct Samples {
+    std::vector<double> ms;
+    std::vector<double> cycles;
+    std::vector<double> cache_misses;
+    std::vector<double> branch_misses;
+
+    void add(double elapsed_ms, const CounterValues& counters) {
+        ms.push_back(elapsed_ms);
+        if (!counters.valid) return;
+        cycles.push_back((double)counters.cycles);
+        cache_misses.push_back((double)counters.cache_misses);
+        branch_misses.push_back((double)counters.branch_misses);
+    }
+};
+
+struct Stage {
+    std::string name;
+    Samples samples;
+};
+
+// Runs `body` once, timing it and, unless `counted` is false, counting it on the hardware
+// counters. The counters follow the calling thread only, so stages that run on several
+// threads are timed without them rather than reported with part of their work.
+template <typename Body>
+void measure(Samples& samples, PerfCounters& counters, Body&& body, bool counted = true) {
+    auto start = std::chrono::steady_clock::now();
+    if (counted) counters.start();
+    body();
+    CounterValues values = counted ? counters.stop() : CounterValues();
+    samples.add(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(), values);
+}
+
+std::string jsonString(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if ((unsigned char)c < 0x20) {
+            char escaped[7];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned)c);
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+// {"median", "mean", "variance", "min", "max"} of the values; the variance is the sample
+// variance (n - 1), 0 for a single value.
+std::string jsonSummary(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    double median = n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+    double mean = 0;
+    for (double v : values) mean += v;
+    mean /= n;
+    double variance = 0;
+    for (double v : values) variance += (v - mean) * (v - mean);
+    variance = n > 1 ? variance / (n - 1) : 0;
+
+    std::ostringstream out;
+    out.precision(10);
+    out << "{\"median\": " << median << ", \"mean\": " << mean << ", \"variance\": " << variance << ", \"min\": "
+        << values.front() << ", \"max\": " << values.back() << "}";
+    return out.str();
+}
+
+// Usage: Task5_suite transactions.csv [--trials N] [--warmup N] [--threads N] [--json FILE]
+// Times each stage of block construction separately over repeated trials and writes the
+// results as JSON, to stdout unless --json is given. The warm-up trials are not recorded.
+int main(int argc, char** argv) {
+    std::string filename = "transactions.csv";
+    std::string json_file;
+    int trials = 10;
+    int warmup = 1;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    try {
+        for (int i = 1; i < argc; i++) {
+            bool has_value = i + 1 < argc;
+            if (std::strcmp(argv[i], "--trials") == 0 && has_value) {
+                trials = std::max(1, std::stoi(argv[++i]));
+            } else if (std::strcmp(argv[i], "--warmup") == 0 && has_value) {
+                warmup = std::max(0, std::stoi(argv[++i]));
+            } else if (std::strcmp(argv[i], "--threads") == 0 && has_value) {
+                threads = std::max(1ul, std::stoul(argv[++i]));
+            } else if (std::strcmp(argv[i], "--json") == 0 && has_value) {
+                json_file = argv[++i];
+            } else {
+                filename = argv[i];
+            }
+        }
+    } catch (const std::exception&) {
+        std::cerr << "Usage: Task5_suite transactions.csv [--trials N] [--warmup N] [--threads N] [--json FILE]" << std::endl;
+        return 1;
+    }
+
+    PerfCounters counters;
+    std::vector<Stage> stages;
+    auto stage = [&](const std::string& name) -> Samples& {
+        for (auto& s : stages) {
+            if (s.name == name) return s.samples;
+        }
+        stages.push_back({name, {}});
+        return stages.back().samples;
+    };
+
+    size_t file_bytes = 0, rows = 0, skipped_rows = 0;
+    bool parents = false;
+    long long greedy_fee = 0, selected_fee = 0, package_fee = 0;
+
+    for (int trial = 0; trial < warmup + trials; trial++) {
+        Samples discard;
+        auto slot = [&](const std::string& name) -> Samples& { return trial < warmup ? discard : stage(name); };
+
+        // The IDs point into the file, so it stays mapped for the whole trial.
+        std::unique_ptr<MappedFile> file;
+        std::vector<Transaction> txs;
+        try {
+            measure(slot("load"), counters, [&] {
+                file = std::make_unique<MappedFile>(filename);
+                txs = loadTransactions(*file, threads, &skipped_rows);
+            }, threads == 1);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        if (txs.empty()) {
+            std::cerr << "No data found or file error." << std::endl;
+            return 1;
+        }
+        file_bytes = file->view().size();
+        rows = txs.size();
+        parents = hasParents(txs);
+
+        // The density greedy pass of constructBlock, in its two steps.
+        std::vector<Transaction> sorted = txs;
+        measure(slot("sort"), counters, [&] { sortByDensity(sorted); });
+        std::vector<uint32_t> picked;
+        measure(slot("select"), counters, [&] { picked = pickGreedy(sorted, MB); });
+        greedy_fee = 0;
+        for (uint32_t i : picked) greedy_fee += sorted[i].fee;
+
+        // The same block through the struct-of-arrays store.
+        std::optional<TransactionStore> store;
+        measure(slot("store_build"), counters, [&] { store.emplace(txs); });
+        BlockResult selected;
+        measure(slot("store_select"), counters, [&] { selected = selectBlock(*store, MB); });
+        selected_fee = selected.total_fee;
+        if (selected_fee != greedy_fee) {
+            std::cerr << "selectBlock and the greedy pass disagree: " << selected_fee << " vs " << greedy_fee << std::endl;
+            return 1;
+        }
+
+        if (parents) {
+            MempoolGraph graph;
+            measure(slot("graph"), counters, [&] { graph = buildGraph(txs); });
+            BlockResult packages;
+            measure(slot("packages"), counters, [&] { packages = constructPackageBlock(txs, graph, MB); });
+            package_fee = packages.total_fee;
+        }
+    }
+
+    std::ostringstream json;
+    json << "{\n";
+    json << "  \"input\": {\"file\": " << jsonString(filename) << ", \"bytes\": " << file_bytes << ", \"rows\": " << rows
+         << ", \"skipped_rows\": " << skipped_rows << ", \"has_parents\": " << (parents ? "true" : "false") << "},\n";
+#ifdef __VERSION__
+    json << "  \"build\": {\"compiler\": " << jsonString(__VERSION__);
+#else
+    json << "  \"build\": {\"compiler\": null";
+#endif
+#ifdef NDEBUG
+    json << ", \"ndebug\": true},\n";
+#else
+    json << ", \"ndebug\": false},\n";
+#endif
+    json << "  \"trials\": " << trials << ",\n";
+    json << "  \"warmup\": " << warmup << ",\n";
+    json << "  \"threads\": " << threads << ",\n";
+    json << "  \"max_capacity\": " << MB << ",\n";
+    json << "  \"counters\": " << (counters.available() ? "true" : "false") << ",\n";
+    json << "  \"fees\": {\"greedy\": " << greedy_fee << ", \"store_select\": " << selected_fee;
+    if (parents) json << ", \"packages\": " << package_fee;
+    json << "},\n";
+    json << "  \"stages\": {\n";
+    for (size_t s = 0; s < stages.size(); s++) {
+        const Samples& samples = stages[s].samples;
+        json << "    " << jsonString(stages[s].name) << ": {\n";
+        json << "      \"ms\": " << jsonSummary(samples.ms);
+        if (samples.cycles.size() == samples.ms.size()) {
+            json << ",\n      \"cycles\": " << jsonSummary(samples.cycles);
+            json << ",\n      \"cache_misses\": " << jsonSummary(samples.cache_misses);
+            json << ",\n      \"branch_misses\": " << jsonSummary(samples.branch_misses);
+        }
+        json << "\n    }" << (s + 1 < stages.size() ? "," : "") << "\n";
+    }
+    json << "  }\n}\n";
+
+    if (json_file.empty()) {
+        std::cout << json.str();
+        return 0;
+    }
+    std::ofstream out(json_file);
+    out << json.str();
+    if (!out) {
+        std::cerr << "Failed to write " << json_file << "." << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <random>
+#include <string>
+
+// Shape of a generated mempool.
+struct MempoolShape {
+    size_t count = 300000;
+    uint64_t seed = 1;
+    double child_share = 0.3;   // share of transactions that spend unconfirmed parents
+    int parent_window = 2000;   // parents are picked among this many previous transactions
+    double fee_sigma = 1.3;     // spread of the log feerate; larger makes the fees more skewed
+};
+
+// 64 hex digits derived from `n` (SplitMix64), standing in for a transaction hash.
+inline std::string syntheticTxId(uint64_t n) {
+    char id[65];
+    for (int part = 0; part < 4; part++) {
+        uint64_t z = n * 4 + part + 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z ^= z >> 31;
+        std::snprintf(id + part * 16, 17, "%016llx", (unsigned long long)z);
+    }
+    return std::string(id, 64);
+}
+
+// Writes a mempool as CSV ("tx_id,size,fee,parents"). Sizes are log-normal around 300 bytes
+// and feerates log-normal around 5 sat/byte with a long tail (`fee_sigma`). Children pay a
+// higher feerate than the average, the way child-pays-for-parent bumps look, and now and then
+// spend two parents. The same shape always gives the same file.
+inline void writeMempoolCsv(std::ostream& out, const MempoolShape& shape) {
+    std::mt19937_64 rng(shape.seed);
+    std::lognormal_distribution<double> sizes(std::log(300.0), 0.9);
+    std::lognormal_distribution<double> feerates(std::log(5.0), shape.fee_sigma);
+    std::uniform_real_distribution<double> chance(0, 1);
+
+    out << "tx_id,size,fee,parents\n";
+    for (size_t i = 0; i < shape.count; i++) {
+        int size = (int)std::clamp(sizes(rng), 100.0, 100000.0);
+        double feerate = feerates(rng);
+        std::string parents;
+        if (i > 0 && chance(rng) < shape.child_share) {
+            int parent_count = chance(rng) < 0.2 ? 2 : 1;
+            size_t window = std::min<size_t>(i, (size_t)shape.parent_window);
+            for (int k = 0; k < parent_count; k++) {
+                size_t parent = i - 1 - (size_t)(chance(rng) * window);
+                if (!parents.empty()) parents += ';';
+                parents += syntheticTxId(parent);
+            }
+            feerate *= 3;
+        }
+        long long fee = std::max(1LL, std::llround(size * feerate));
+        out << syntheticTxId(i) << ',' << size << ',' << fee << ',' << parents << '\n';
+    }
+}
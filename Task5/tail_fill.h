@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "transactions.h"
+
+// Exact 0/1 knapsack over a short list of transactions in density order, by depth-first
+// branch and bound: take or skip each transaction in turn, and prune a branch when even the
+// fractional (LP) fill of its space with the transactions left cannot beat the best fee
+// found so far. Stops when the time budget runs out and keeps the best selection found.
+class TailKnapsack {
+private:
+    static constexpr uint64_t NODES_PER_CLOCK_CHECK = 1024;
+
+    const std::vector<Transaction>& items;
+    std::vector<uint8_t> taking;
+    std::vector<uint8_t> best_taken;
+    long long best_fee;
+    uint64_t nodes = 0;
+    bool out_of_time = false;
+    std::chrono::steady_clock::time_point deadline;
+
+    double bound(size_t i, long long space, long long fee) const {
+        double result = (double)fee;
+        for (; i < items.size(); i++) {
+            if (items[i].size <= space) {
+                space -= items[i].size;
+                result += (double)items[i].fee;
+            } else {
+                return result + items[i].density * space;
+            }
+        }
+        return result;
+    }
+
+    void search(size_t i, long long space, long long fee) {
+        if (fee > best_fee) {
+            best_fee = fee;
+            best_taken = taking;
+        }
+        if (i == items.size() || out_of_time) return;
+        if (++nodes % NODES_PER_CLOCK_CHECK == 0 && std::chrono::steady_clock::now() > deadline) {
+            out_of_time = true;
+            return;
+        }
+        if (bound(i, space, fee) <= (double)best_fee) return;
+
+        if (items[i].size <= space) {
+            taking[i] = 1;
+            search(i + 1, space - items[i].size, fee + items[i].fee);
+            taking[i] = 0;
+        }
+        search(i + 1, space, fee);
+    }
+
+public:
+    // `taken` is the starting selection, which the result never does worse than.
+    TailKnapsack(const std::vector<Transaction>& candidates, const std::vector<uint8_t>& taken)
+        : items(candidates), taking(candidates.size(), 0), best_taken(taken), best_fee(0) {
+        for (size_t i = 0; i < items.size(); i++) {
+            if (taken[i]) best_fee += items[i].fee;
+        }
+    }
+
+    const std::vector<uint8_t>& solve(long long space, double budget_ms) {
+        deadline = std::chrono::steady_clock::now() + std::chrono::microseconds((long long)(budget_ms * 1000));
+        search(0, space, 0);
+        return best_taken;
+    }
+};
+
+// Repacks the end of a greedy block. `txs` is sorted by density and `picked` holds the
+// indices the greedy pass took, in order. Everything before the first transaction the greedy
+// pass skipped is kept except the last TAIL_KEEP_BACK of it. Those, and the next
+// TAIL_LOOK_AHEAD transactions, are re-chosen by TailKnapsack within `budget_ms`, with the
+// greedy choice as the starting point. Greedy picks after that window stay as they are.
+// Returns the fee gained; `picked` is updated.
+inline long long fillTail(const std::vector<Transaction>& txs, std::vector<uint32_t>& picked, int max_capacity, double budget_ms) {
+    const size_t TAIL_KEEP_BACK = 64;
+    const size_t TAIL_LOOK_AHEAD = 512;
+
+    size_t cutoff = 0;
+    while (cutoff < picked.size() && picked[cutoff] == cutoff) cutoff++;
+    if (cutoff == txs.size()) return 0;   // everything fits
+
+    size_t window_begin = cutoff > TAIL_KEEP_BACK ? cutoff - TAIL_KEEP_BACK : 0;
+    size_t window_end = std::min(txs.size(), cutoff + TAIL_LOOK_AHEAD);
+
+    std::vector<Transaction> candidates(txs.begin() + window_begin, txs.begin() + window_end);
+    std::vector<uint8_t> taken(candidates.size(), 0);
+    long long space = max_capacity;
+    for (uint32_t i : picked) {
+        if (i >= window_begin && i < window_end) {
+            taken[i - window_begin] = 1;
+        } else {
+            space -= txs[i].size;
+        }
+    }
+
+    long long greedy_fee = 0;
+    for (size_t i = 0; i < candidates.size(); i++) {
+        if (taken[i]) greedy_fee += candidates[i].fee;
+    }
+
+    TailKnapsack knapsack(candidates, taken);
+    const std::vector<uint8_t>& best = knapsack.solve(space, budget_ms);
+
+    long long gain = -greedy_fee;
+    std::vector<uint32_t> result;
+    result.reserve(picked.size() + candidates.size());
+    for (uint32_t i = 0; i < window_begin; i++) {
+        result.push_back(i);
+    }
+    for (size_t i = 0; i < candidates.size(); i++) {
+        if (!best[i]) continue;
+        result.push_back((uint32_t)(window_begin + i));
+        gain += candidates[i].fee;
+    }
+    for (uint32_t i : picked) {
+        if (i >= window_end) result.push_back(i);
+    }
+    picked = std::move(result);
+    return gain;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "block.h"
+#include "transactions.h"
+
+// Transactions as a struct of arrays. Selection only touches `order`, packed 16-byte
+// (density key, index) pairs, and the sizes and fees of the transactions it takes; the IDs
+// are only read for the block itself.
+struct TransactionStore {
+    struct Ranked {
+        uint64_t key;     // ascending key = descending density
+        uint32_t index;
+
+        bool operator<(const Ranked& other) const {
+            return key < other.key || (key == other.key && index < other.index);
+        }
+    };
+
+    std::vector<std::string_view> ids;
+    std::vector<int> sizes;
+    std::vector<long long> fees;
+    std::vector<Ranked> order;
+
+    // Maps a density to an integer with the opposite order: flipping the sign bit (or all bits
+    // for negative values) makes the IEEE bits ordered like the doubles, and ~ reverses that.
+    static uint64_t densityKey(double density) {
+        uint64_t bits;
+        std::memcpy(&bits, &density, sizeof(bits));
+        bits = (bits >> 63) ? ~bits : bits | (1ULL << 63);
+        return ~bits;
+    }
+
+    explicit TransactionStore(const std::vector<Transaction>& txs) {
+        ids.reserve(txs.size());
+        sizes.reserve(txs.size());
+        fees.reserve(txs.size());
+        order.reserve(txs.size());
+        for (uint32_t i = 0; i < txs.size(); i++) {
+            ids.push_back(txs[i].id);
+            sizes.push_back(txs[i].size);
+            fees.push_back(txs[i].fee);
+            order.push_back({densityKey(txs[i].density), i});
+        }
+    }
+
+    size_t size() const { return sizes.size(); }
+};
+
+// The greedy pass of constructBlock without sorting the whole store. Density ties go by
+// position in the store.
+//  1. The densest `head` transactions, enough to fill the block about twice over at the
+//     average size, are picked with nth_element, sorted, and run through the greedy pass.
+//  2. A transaction that did not fit then can never fit later, since the space left only
+//     shrinks. So only the rest with sizes up to the space left are sorted and run through.
+// The result is exact whatever `head` is; its size only decides how much ends up in step 2.
+// O(N + H log H + R log R) for H head and R remaining candidates, against O(N log N).
+inline BlockResult selectBlock(TransactionStore& store, int max_capacity) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::vector<TransactionStore::Ranked>& order = store.order;
+    long long total_size = 0;
+    for (int size : store.sizes) total_size += size;
+    double average_size = store.size() ? (double)total_size / store.size() : 1;
+    size_t head = std::min(order.size(), (size_t)(2.0 * max_capacity / average_size) + 1024);
+
+    std::nth_element(order.begin(), order.begin() + head, order.end());
+    std::sort(order.begin(), order.begin() + head);
+
+    std::vector<uint32_t> picked;
+    int current_size = 0;
+    auto take = [&](auto begin, auto end) {
+        for (auto it = begin; it != end; ++it) {
+            int size = store.sizes[it->index];
+            if (current_size + size <= max_capacity) {
+                picked.push_back(it->index);
+                current_size += size;
+            }
+        }
+    };
+    take(order.begin(), order.begin() + head);
+
+    auto rest_end = std::partition(order.begin() + head, order.end(), [&](const TransactionStore::Ranked& r) {
+        return current_size + store.sizes[r.index] <= max_capacity;
+    });
+    std::sort(order.begin() + head, rest_end);
+    take(order.begin() + head, rest_end);
+
+    std::vector<std::string_view> selected_ids;
+    selected_ids.reserve(picked.size());
+    long long current_fee = 0;
+    for (uint32_t i : picked) {
+        selected_ids.push_back(store.ids[i]);
+        current_fee += store.fees[i];
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    return {
+        selected_ids,
+        current_size,
+        current_fee,
+        std::chrono::duration<double, std::milli>(end - start).count(),
+        getPeakMemory()
+    };
+}
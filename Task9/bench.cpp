@@ -0,0 +1,139 @@
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bigint.h"
+using namespace std;
+
+BigNatural randomNatural(size_t limbs, mt19937_64& rng) {
+    string s = to_string(1 + rng() % 9);
+    while (s.size() < limbs * 9) s += char('0' + rng() % 10);
+    return BigNatural(s);
+}
+
+// Milliseconds per call of `operation`, repeated until at least 50 ms have passed.
+template <typename Operation>
+double timeOperation(Operation operation) {
+    auto start = chrono::steady_clock::now();
+    int runs = 0;
+    double elapsed;
+    do {
+        operation();
+        runs++;
+        elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    } while (elapsed < 50);
+    return elapsed / runs;
+}
+
+// Times the operation that `makeOperation(n)` returns with the algorithm forced on at the top
+// level (`threshold` = n) and off (n + 1), for each n in `sizes`. Returns the first size from
+// which the algorithm wins for the rest of the sizes.
+template <typename MakeOperation>
+size_t findCrossover(const char* name, size_t& threshold, const vector<size_t>& sizes, MakeOperation makeOperation) {
+    size_t crossover = sizes.back() + 1;
+    size_t saved = threshold;
+    cout << name << " crossover:" << endl;
+    for (size_t n : sizes) {
+        auto operation = makeOperation(n);
+        threshold = n + 1;
+        double below = timeOperation(operation);
+        threshold = n;
+        double above = timeOperation(operation);
+        cout << "    " << setw(6) << n << " limbs: " << setw(10) << below * 1000 << " us without, " << setw(10)
+             << above * 1000 << " us with (" << below / above << "x)" << endl;
+        if (above < below) {
+            crossover = min(crossover, n);
+        } else {
+            crossover = sizes.back() + 1;
+        }
+    }
+    threshold = saved;
+    return crossover;
+}
+
+// Usage: Task9_bench [max_limbs] [max_division_limbs]
+int main(int argc, char** argv) {
+    size_t max_limbs = argc > 1 ? stoul(argv[1]) : 1111112;   // 10 million digits
+    size_t max_division_limbs = argc > 2 ? stoul(argv[2]) : 131072;
+    mt19937_64 rng(9);
+    cout << fixed << setprecision(2);
+    auto product = [&](size_t n) {
+        BigNatural x = randomNatural(n, rng), y = randomNatural(n, rng);
+        return [x, y] { return x * y; };
+    };
+    // A 2n-limb number by an n-limb one: an n-limb divisor and an (n + 1)-limb quotient.
+    auto quotient = [&](size_t n) {
+        BigNatural x = randomNatural(2 * n, rng), y = randomNatural(n, rng);
+        return [x, y] { return x / y; };
+    };
+
+    // Crossovers are measured with only the algorithm below enabled, from the current
+    // thresholds' point of view.
+    size_t toom = BigNatural::toomThreshold;
+    BigNatural::toomThreshold = SIZE_MAX;
+    size_t karatsuba = findCrossover("Karatsuba", BigNatural::karatsubaThreshold, {8, 12, 16, 20, 24, 28, 32, 40, 48, 64, 80, 96}, product);
+    BigNatural::toomThreshold = toom;
+    size_t toom3 = findCrossover("Toom-3", BigNatural::toomThreshold, {128, 192, 256, 320, 384, 512, 640, 768, 1024, 1536, 2048}, product);
+    size_t ntt = findCrossover("NTT", BigNatural::nttThreshold, {256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096}, product);
+    size_t newton = findCrossover("Newton division", BigNatural::newtonThreshold, {64, 128, 256, 384, 512, 768, 1024, 1536, 2048, 4096}, quotient);
+    cout << "Measured thresholds: Karatsuba from " << karatsuba << " limbs, Toom-3 from " << toom3 << " limbs, NTT from "
+         << ntt << " limbs, Newton division from " << newton << " limbs (built in: " << BigNatural::karatsubaThreshold
+         << ", " << BigNatural::toomThreshold << ", " << BigNatural::nttThreshold << ", " << BigNatural::newtonThreshold
+         << ")" << endl;
+
+    // Sizes doubling up to max_limbs; the slower algorithms only while they take seconds.
+    cout << "Product of two n-limb numbers (9 decimal digits per limb):" << endl;
+    vector<size_t> sizes;
+    for (size_t n = 1; n < max_limbs; n *= 2) sizes.push_back(n);
+    sizes.push_back(max_limbs);
+    for (size_t n : sizes) {
+        BigNatural x = randomNatural(n, rng), y = randomNatural(n, rng);
+        double fast = timeOperation([&] { return x * y; });
+        cout << "    " << setw(7) << n << " limbs (" << setw(8) << n * 9 << " digits): " << setw(10) << fast << " ms";
+        if (n >= BigNatural::nttThreshold && n <= 131072) {
+            size_t saved = BigNatural::nttThreshold;
+            BigNatural::nttThreshold = SIZE_MAX;
+            double toom_only = timeOperation([&] { return x * y; });
+            BigNatural::nttThreshold = saved;
+            cout << ", without NTT " << setw(10) << toom_only << " ms (" << toom_only / fast << "x)";
+        }
+        if (n <= 8192) {
+            double schoolbook = timeOperation([&] { return BigNatural::multiplySchoolbook(x, y); });
+            cout << ", schoolbook " << setw(10) << schoolbook << " ms (" << schoolbook / fast << "x)";
+        }
+        cout << endl;
+    }
+
+    cout << "Quotient of a 2n-limb number by an n-limb one:" << endl;
+    for (size_t n = 2; n <= max_division_limbs; n *= 2) {
+        BigNatural x = randomNatural(2 * n, rng), y = randomNatural(n, rng);
+        double fast = timeOperation([&] { return x / y; });
+        cout << "    " << setw(7) << n << " limbs: " << setw(10) << fast << " ms";
+        if (n >= BigNatural::newtonThreshold && n <= 32768) {
+            size_t saved = BigNatural::newtonThreshold;
+            BigNatural::newtonThreshold = SIZE_MAX;
+            double knuth = timeOperation([&] { return x / y; });
+            BigNatural::newtonThreshold = saved;
+            cout << ", Knuth D " << setw(10) << knuth << " ms (" << knuth / fast << "x)";
+        }
+        if (n <= 512) {
+            double binary_search = timeOperation([&] { return BigNatural::divModBinarySearch(x, y); });
+            cout << ", binary search " << setw(10) << binary_search << " ms (" << binary_search / fast << "x)";
+        }
+        cout << endl;
+    }
+
+    cout << "Quotient of an n-limb number by a one-limb one:" << endl;
+    for (size_t n : {16, 1024, 65536}) {
+        BigNatural x = randomNatural(n, rng), y(123456789);
+        double fast = timeOperation([&] { return x / y; });
+        double binary_search = timeOperation([&] { return BigNatural::divModBinarySearch(x, y); });
+        cout << "    " << setw(7) << n << " limbs: " << setw(10) << fast << " ms, binary search " << setw(10)
+             << binary_search << " ms (" << binary_search / fast << "x)" << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,739 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <stdexcept>
+#include <limits>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include "ntt.h"
+
+class BigNatural {
+protected:
+    std::vector<int> digits;
+    static const int BASE = 1000000000;
+
+    void trim() {
+        while (digits.size() > 1 && digits.back() == 0) {
+            digits.pop_back();
+        }
+    }
+
+public:
+    BigNatural() {
+        digits.push_back(0);
+    }
+
+    BigNatural(unsigned long long n) {
+        if (n == 0) digits.push_back(0);
+        while (n > 0) {
+            digits.push_back(n % BASE);
+            n /= BASE;
+        }
+    }
+
+    BigNatural(std::string s) {
+        if (s.empty()) {
+            digits.push_back(0);
+        } else {
+            for (int i = (int)s.length(); i > 0; i -= 9) {
+                if (i < 9)
+                    digits.push_back(std::stoi(s.substr(0, i)));
+                else
+                    digits.push_back(std::stoi(s.substr(i - 9, 9)));
+            }
+        }
+        trim();
+    }
+
+    std::string toString() const {
+        if (digits.empty()) return "0";
+        std::string s = std::to_string(digits.back());
+        for (int i = (int)digits.size() - 2; i >= 0; --i) {
+            std::string tmp = std::to_string(digits[i]);
+            while (tmp.length() < 9) tmp = "0" + tmp;
+            s += tmp;
+        }
+        return s;
+    }
+
+    long long toLongLong() const {
+        long long res = 0;
+        long long multiplier = 1;
+        if (digits.size() > 3) throw std::out_of_range("BigNatural too large for long long");
+
+        for (size_t i = 0; i < digits.size(); ++i) {
+            res += digits[i] * multiplier;
+            multiplier *= BASE;
+        }
+        return res;
+    }
+
+    bool operator==(const BigNatural& other) const {
+        return digits == other.digits;
+    }
+
+    bool operator!=(const BigNatural& other) const {
+        return !(*this == other);
+    }
+
+    bool operator<(const BigNatural& other) const {
+        if (digits.size() != other.digits.size())
+            return digits.size() < other.digits.size();
+        for (int i = digits.size() - 1; i >= 0; --i) {
+            if (digits[i] != other.digits[i])
+                return digits[i] < other.digits[i];
+        }
+        return false;
+    }
+
+    bool operator>(const BigNatural& other) const { return other < *this; }
+    bool operator<=(const BigNatural& other) const { return !(*this > other); }
+    bool operator>=(const BigNatural& other) const { return !(*this < other); }
+
+    BigNatural operator+(const BigNatural& other) const {
+        BigNatural res;
+        res.digits.clear();
+        int carry = 0;
+        size_t n = std::max(digits.size(), other.digits.size());
+
+        for (size_t i = 0; i < n || carry; ++i) {
+            long long sum = carry + (long long)(i < digits.size() ? digits[i] : 0)
+                                  + (long long)(i < other.digits.size() ? other.digits[i] : 0);
+            res.digits.push_back(sum % BASE);
+            carry = sum / BASE;
+        }
+        return res;
+    }
+
+    BigNatural operator-(const BigNatural& other) const {
+        if (*this < other) throw std::invalid_argument("Result of subtraction is negative (in BigNatural)");
+        BigNatural res;
+        res.digits.clear();
+        int borrow = 0;
+        for (size_t i = 0; i < digits.size(); ++i) {
+            long long sub = (long long)digits[i] - borrow - (i < other.digits.size() ? other.digits[i] : 0);
+            if (sub < 0) {
+                sub += BASE;
+                borrow = 1;
+            } else {
+                borrow = 0;
+            }
+            res.digits.push_back(sub);
+        }
+        res.trim();
+        return res;
+    }
+
+    BigNatural operator*(const BigNatural& other) const {
+        if (isZero() || other.isZero()) return BigNatural();
+        size_t n = digits.size(), m = other.digits.size();
+        BigNatural res;
+        res.digits.resize(n + m);
+        std::vector<int> scratch(mulScratchSize(n, m));
+        mulLimbs(digits.data(), n, other.digits.data(), m, res.digits.data(), scratch.data());
+        res.trim();
+        return res;
+    }
+
+    // The plain O(N * M) product, one carry per inner step. Kept as the reference the faster
+    // algorithms are tested against.
+    static BigNatural multiplySchoolbook(const BigNatural& a, const BigNatural& b) {
+        BigNatural res;
+        res.digits.resize(a.digits.size() + b.digits.size(), 0);
+
+        for (size_t i = 0; i < a.digits.size(); ++i) {
+            long long carry = 0;
+            for (size_t j = 0; j < b.digits.size() || carry; ++j) {
+                long long cur = res.digits[i + j] + a.digits[i] * 1LL * (j < b.digits.size() ? b.digits[j] : 0) + carry;
+                res.digits[i + j] = cur % BASE;
+                carry = cur / BASE;
+            }
+        }
+        res.trim();
+        return res;
+    }
+
+    // Operand sizes (in limbs) from which Karatsuba, Toom-3 and the NTT (ntt.h) take over,
+    // measured with Task9_bench. They can be changed for tuning; Karatsuba never starts below
+    // 8 limbs.
+    static inline size_t karatsubaThreshold = 48;
+    static inline size_t toomThreshold = 256;
+    static inline size_t nttThreshold = 1024;
+
+    // Limbs of scratch space mulLimbs needs for operands of up to n limbs.
+    static size_t mulScratchSize(size_t n) {
+        size_t size = 0;
+        for (; n >= karatsubaCutoff(); n = n / 2 + 2) {
+            size += 4 * n + 32;
+        }
+        return size;
+    }
+
+    // Limbs of scratch space mulLimbs needs for these operands: none when the product goes
+    // straight to the NTT or the basecase, mulScratchSize(max(na, nb)) otherwise.
+    static size_t mulScratchSize(size_t na, size_t nb) {
+        size_t shorter = std::min(na, nb);
+        if (shorter >= nttThreshold && na + nb <= NTT_MAX_LENGTH) return 0;
+        if (shorter < karatsubaCutoff()) return 0;
+        return mulScratchSize(std::max(na, nb));
+    }
+
+    // out[0, na + nb) = a * b on little-endian limb arrays. Every temporary comes from
+    // `scratch`, which must hold mulScratchSize(na, nb) limbs, so nothing is allocated
+    // however deep the recursion goes; only the NTT allocates its own transform arrays.
+    // `out` must not overlap the inputs or the scratch.
+    static void mulLimbs(const int* a, size_t na, const int* b, size_t nb, int* out, int* scratch) {
+        if (na < nb) {
+            std::swap(a, b);
+            std::swap(na, nb);
+        }
+        if (nb >= nttThreshold && na + nb <= NTT_MAX_LENGTH) {
+            nttMultiply(a, na, b, nb, out);
+        } else if (nb < karatsubaCutoff()) {
+            mulBasecase(a, na, b, nb, out);
+        } else if (nb <= (na + 1) / 2) {
+            mulUnbalanced(a, na, b, nb, out, scratch);
+        } else if (nb < toomThreshold || nb <= 2 * ((na + 2) / 3)) {
+            mulKaratsuba(a, na, b, nb, out, scratch);
+        } else {
+            mulToom3(a, na, b, nb, out, scratch);
+        }
+    }
+
+private:
+    static size_t karatsubaCutoff() {
+        return std::max<size_t>(karatsubaThreshold, 8);
+    }
+
+    // Schoolbook by columns: the products of a column are summed in 64 bits and only reduced
+    // every 16 terms (16 * (BASE - 1)^2 plus the carry still fits), instead of a division per
+    // product. The carry into a column is below min(na, nb) * BASE.
+    static void mulBasecase(const int* a, size_t na, const int* b, size_t nb, int* out) {
+        const unsigned long long base = BASE;
+        unsigned long long carry = 0;
+        for (size_t k = 0; k + 1 < na + nb; ++k) {
+            unsigned long long low = carry;
+            unsigned long long high = 0;
+            size_t i_end = std::min(k + 1, na);
+            for (size_t i = k >= nb ? k - nb + 1 : 0;;) {
+                size_t block_end = std::min(i + 16, i_end);
+                for (; i < block_end; ++i) {
+                    low += (unsigned long long)a[i] * (unsigned long long)b[k - i];
+                }
+                if (i == i_end) break;
+                high += low / base;
+                low %= base;
+            }
+            out[k] = (int)(low % base);
+            carry = high + low / base;
+        }
+        out[na + nb - 1] = (int)carry;
+    }
+
+    // out[0, max(nx, ny) + 1) = x + y.
+    static void addLimbs(const int* x, size_t nx, const int* y, size_t ny, int* out) {
+        size_t n = std::max(nx, ny);
+        int carry = 0;
+        for (size_t i = 0; i < n; ++i) {
+            int sum = carry + (i < nx ? x[i] : 0) + (i < ny ? y[i] : 0);
+            carry = sum >= BASE;
+            out[i] = carry ? sum - BASE : sum;
+        }
+        out[n] = carry;
+    }
+
+    // x[0, nx) += y[0, ny). The sum must fit in nx limbs; limbs of y past nx must be zero.
+    static void addInPlace(int* x, size_t nx, const int* y, size_t ny) {
+        int carry = 0;
+        for (size_t i = 0; i < nx && (i < ny || carry); ++i) {
+            int sum = x[i] + carry + (i < ny ? y[i] : 0);
+            carry = sum >= BASE;
+            x[i] = carry ? sum - BASE : sum;
+        }
+    }
+
+    // x[0, nx) -= y[0, ny) * factor, for ny <= nx and a result that is not negative.
+    static void subMulInPlace(int* x, size_t nx, const int* y, size_t ny, int factor) {
+        long long borrow = 0;
+        for (size_t i = 0; i < nx && (i < ny || borrow); ++i) {
+            long long cur = x[i] - borrow - (i < ny ? y[i] * 1LL * factor : 0);
+            borrow = 0;
+            if (cur < 0) {
+                borrow = (-cur + BASE - 1) / BASE;
+                cur += borrow * BASE;
+            }
+            x[i] = (int)cur;
+        }
+    }
+
+    // x[0, nx) /= divisor, which must divide it exactly.
+    static void divExactInPlace(int* x, size_t nx, int divisor) {
+        long long rem = 0;
+        for (size_t i = nx; i-- > 0;) {
+            long long cur = x[i] + rem * BASE;
+            x[i] = (int)(cur / divisor);
+            rem = cur % divisor;
+        }
+    }
+
+    // A long operand against one at most half its length: the long one is cut into pieces as
+    // long as the short one, and the balanced products are added up. Needs 2 * nb limbs of
+    // scratch on top of the products'.
+    static void mulUnbalanced(const int* a, size_t na, const int* b, size_t nb, int* out, int* scratch) {
+        mulLimbs(a, nb, b, nb, out, scratch);
+        std::fill(out + 2 * nb, out + na + nb, 0);
+        int* piece = scratch;
+        for (size_t offset = nb; offset < na; offset += nb) {
+            size_t len = std::min(nb, na - offset);
+            mulLimbs(a + offset, len, b, nb, piece, scratch + 2 * nb);
+            addInPlace(out + offset, na + nb - offset, piece, len + nb);
+        }
+    }
+
+    // Split at h limbs, a = a1 * B^h + a0 and the same for b:
+    //   a * b = z2 * B^2h + ((a0 + a1)(b0 + b1) - z0 - z2) * B^h + z0,  z0 = a0 b0,  z2 = a1 b1.
+    // z0 and z2 are written straight into `out`; the middle product takes 4h + 4 limbs of
+    // scratch. O(N^1.585).
+    static void mulKaratsuba(const int* a, size_t na, const int* b, size_t nb, int* out, int* scratch) {
+        size_t h = (na + 1) / 2;
+        size_t n = na + nb;
+        mulLimbs(a, h, b, h, out, scratch);
+        mulLimbs(a + h, na - h, b + h, nb - h, out + 2 * h, scratch);
+
+        int* sum_a = scratch;
+        int* sum_b = sum_a + (h + 1);
+        int* middle = sum_b + (h + 1);
+        addLimbs(a, h, a + h, na - h, sum_a);
+        addLimbs(b, h, b + h, nb - h, sum_b);
+        mulLimbs(sum_a, h + 1, sum_b, h + 1, middle, middle + 2 * (h + 1));
+
+        subMulInPlace(middle, 2 * h + 2, out, 2 * h, 1);
+        subMulInPlace(middle, 2 * h + 2, out + 2 * h, n - 2 * h, 1);
+        addInPlace(out + h, n - h, middle, 2 * h + 2);
+    }
+
+    // out[0, k] = x0 + t * x1 + t^2 * x2 for pieces of k, k and n2 <= k limbs, t <= 3.
+    static void evaluate(const int* x, size_t k, size_t n2, int t, int* out) {
+        long long carry = 0;
+        for (size_t i = 0; i < k; ++i) {
+            long long cur = carry + x[i] + t * 1LL * x[k + i] + (i < n2 ? t * t * 1LL * x[2 * k + i] : 0);
+            out[i] = (int)(cur % BASE);
+            carry = cur / BASE;
+        }
+        out[k] = (int)carry;
+    }
+
+    // Split into three pieces of k limbs, a = a2 * B^2k + a1 * B^k + a0, and the product is
+    // the polynomial r(x) = r4 x^4 + ... + r0 at x = B^k. It is evaluated at 0, 1, 2, 3 and
+    // infinity (five products of about a third of the size) and interpolated:
+    //   u1 = r(1) - r0 - r4            = r1 + r2 + r3
+    //   u2 = (r(2) - r0 - 16 r4) / 2   = r1 + 2 r2 + 4 r3
+    //   u3 = (r(3) - r0 - 81 r4) / 3   = r1 + 3 r2 + 9 r3
+    //   r3 = ((u3 - u2) - (u2 - u1)) / 2,  r2 = (u2 - u1) - 3 r3,  r1 = u1 - r2 - r3.
+    // The points are all positive, so every intermediate value is a natural number and the
+    // limb routines above are enough. Takes 8k + 8 limbs of scratch. O(N^1.465).
+    static void mulToom3(const int* a, size_t na, const int* b, size_t nb, int* out, int* scratch) {
+        size_t k = (na + 2) / 3;
+        size_t na2 = na - 2 * k, nb2 = nb - 2 * k;
+        size_t n = na + nb;
+        size_t len = 2 * k + 2;
+        mulLimbs(a, k, b, k, out, scratch);
+        mulLimbs(a + 2 * k, na2, b + 2 * k, nb2, out + 4 * k, scratch);
+        std::fill(out + 2 * k, out + 4 * k, 0);
+        const int* r0 = out;
+        const int* r4 = out + 4 * k;
+        size_t n4 = na2 + nb2;
+
+        int* eval_a = scratch;
+        int* eval_b = eval_a + (k + 1);
+        int* w1 = eval_b + (k + 1);
+        int* w2 = w1 + len;
+        int* w3 = w2 + len;
+        int* rest = w3 + len;
+        int* points[3] = {w1, w2, w3};
+        for (int t = 1; t <= 3; ++t) {
+            evaluate(a, k, na2, t, eval_a);
+            evaluate(b, k, nb2, t, eval_b);
+            mulLimbs(eval_a, k + 1, eval_b, k + 1, points[t - 1], rest);
+        }
+
+        subMulInPlace(w1, len, r0, 2 * k, 1);
+        subMulInPlace(w1, len, r4, n4, 1);
+        subMulInPlace(w2, len, r0, 2 * k, 1);
+        subMulInPlace(w2, len, r4, n4, 16);
+        divExactInPlace(w2, len, 2);
+        subMulInPlace(w3, len, r0, 2 * k, 1);
+        subMulInPlace(w3, len, r4, n4, 81);
+        divExactInPlace(w3, len, 3);
+
+        subMulInPlace(w3, len, w2, len, 1);
+        subMulInPlace(w2, len, w1, len, 1);
+        subMulInPlace(w3, len, w2, len, 1);
+        divExactInPlace(w3, len, 2);
+        subMulInPlace(w2, len, w3, len, 3);
+        subMulInPlace(w1, len, w2, len, 1);
+        subMulInPlace(w1, len, w3, len, 1);
+
+        addInPlace(out + k, n - k, w1, len);
+        addInPlace(out + 2 * k, n - 2 * k, w2, len);
+        addInPlace(out + 3 * k, n - 3 * k, w3, len);
+    }
+
+public:
+    // Quotient and remainder. A one-limb divisor takes a single pass; otherwise Knuth's
+    // Algorithm D, or division by a Newton reciprocal when both the divisor and the quotient
+    // reach newtonThreshold limbs.
+    static std::pair<BigNatural, BigNatural> div_mod(const BigNatural& a, const BigNatural& b) {
+        if (b.digits.size() == 1 && b.digits[0] == 0) throw std::runtime_error("Division by zero");
+        if (a < b) return {BigNatural(0), a};
+
+        if (b.digits.size() == 1) return divSmall(a, b.digits[0]);
+        size_t quotient_limbs = a.digits.size() - b.digits.size() + 1;
+        if (std::min(b.digits.size(), quotient_limbs) >= newtonThreshold) return divNewton(a, b);
+        return divKnuth(a, b);
+    }
+
+    // The original division: each quotient limb found by binary search over [0, BASE), about
+    // 30 multiplications of the divisor per limb. Kept as the reference the faster algorithms
+    // are tested against.
+    static std::pair<BigNatural, BigNatural> divModBinarySearch(const BigNatural& a, const BigNatural& b) {
+        if (b.digits.size() == 1 && b.digits[0] == 0) throw std::runtime_error("Division by zero");
+        if (a < b) return {BigNatural(0), a};
+
+        BigNatural quotient;
+        quotient.digits.resize(a.digits.size());
+        BigNatural remainder = 0;
+
+        for (int i = a.digits.size() - 1; i >= 0; --i) {
+            if (!(remainder.digits.size() == 1 && remainder.digits[0] == 0)) {
+                remainder.digits.insert(remainder.digits.begin(), a.digits[i]);
+            } else {
+                remainder.digits[0] = a.digits[i];
+            }
+
+            int l = 0, r = BASE - 1;
+            int best = 0;
+            while (l <= r) {
+                int m = l + (r - l) / 2;
+                if (b * BigNatural(m) <= remainder) {
+                    best = m;
+                    l = m + 1;
+                } else {
+                    r = m - 1;
+                }
+            }
+
+            quotient.digits[i] = best;
+            remainder = remainder - (b * BigNatural(best));
+        }
+        quotient.trim();
+        remainder.trim();
+        return {quotient, remainder};
+    }
+
+    // Divisor and quotient size (in limbs) from which division goes through a Newton
+    // reciprocal, measured with Task9_bench.
+    static inline size_t newtonThreshold = 3072;
+
+private:
+    static BigNatural fromLimbs(const int* limbs, size_t n) {
+        BigNatural res;
+        if (n == 0) return res;
+        res.digits.assign(limbs, limbs + n);
+        res.trim();
+        return res;
+    }
+
+    // x * BASE^k.
+    static BigNatural shiftUp(const BigNatural& x, size_t k) {
+        if (x.isZero()) return x;
+        BigNatural res;
+        res.digits.assign(k, 0);
+        res.digits.insert(res.digits.end(), x.digits.begin(), x.digits.end());
+        return res;
+    }
+
+    // x / BASE^k, rounded down.
+    static BigNatural shiftDown(const BigNatural& x, size_t k) {
+        if (k >= x.digits.size()) return BigNatural();
+        return fromLimbs(x.digits.data() + k, x.digits.size() - k);
+    }
+
+    // One pass from the top limb, carrying the remainder.
+    static std::pair<BigNatural, BigNatural> divSmall(const BigNatural& a, int divisor) {
+        BigNatural quotient;
+        quotient.digits.resize(a.digits.size());
+        long long rem = 0;
+        for (size_t i = a.digits.size(); i-- > 0;) {
+            long long cur = a.digits[i] + rem * BASE;
+            quotient.digits[i] = (int)(cur / divisor);
+            rem = cur % divisor;
+        }
+        quotient.trim();
+        return {quotient, BigNatural((unsigned long long)rem)};
+    }
+
+    // x[0, n) *= factor in place, returning the limb carried out.
+    static int mulSmallInPlace(int* x, size_t n, int factor) {
+        long long carry = 0;
+        for (size_t i = 0; i < n; ++i) {
+            long long cur = x[i] * 1LL * factor + carry;
+            x[i] = (int)(cur % BASE);
+            carry = cur / BASE;
+        }
+        return (int)carry;
+    }
+
+    // Knuth, TAOCP vol. 2, 4.3.1, Algorithm D. Both operands are scaled so that the top limb
+    // of the divisor is at least BASE / 2. Each quotient limb is then estimated from the top
+    // two limbs of the running remainder and corrected with the divisor's second limb, which
+    // leaves it at most one too large. The divisor times the estimate is subtracted in place
+    // from the remainder, and added back in the rare case the estimate was one too large.
+    // O(N * M) for an N-limb quotient and an M-limb divisor.
+    static std::pair<BigNatural, BigNatural> divKnuth(const BigNatural& a, const BigNatural& b) {
+        size_t n = b.digits.size();
+        size_t m = a.digits.size() - n;
+        int scale = BASE / (b.digits.back() + 1);
+
+        std::vector<int> v = b.digits;
+        mulSmallInPlace(v.data(), n, scale);
+        std::vector<int> u = a.digits;
+        u.push_back(mulSmallInPlace(u.data(), u.size(), scale));
+
+        BigNatural quotient;
+        quotient.digits.assign(m + 1, 0);
+        const unsigned long long base = BASE;
+        unsigned long long top = v[n - 1], second = v[n - 2];
+        for (size_t j = m + 1; j-- > 0;) {
+            unsigned long long numerator = u[j + n] * base + u[j + n - 1];
+            unsigned long long qhat = numerator / top;
+            unsigned long long rhat = numerator % top;
+            while (qhat >= base || qhat * second > rhat * base + u[j + n - 2]) {
+                --qhat;
+                rhat += top;
+                if (rhat >= base) break;
+            }
+
+            long long borrow = 0;
+            unsigned long long carry = 0;
+            for (size_t i = 0; i < n; ++i) {
+                unsigned long long product = qhat * v[i] + carry;
+                carry = product / base;
+                long long cur = u[i + j] - (long long)(product % base) - borrow;
+                borrow = cur < 0;
+                u[i + j] = (int)(cur < 0 ? cur + BASE : cur);
+            }
+            long long last = u[j + n] - (long long)carry - borrow;
+
+            if (last < 0) {
+                --qhat;
+                int add_carry = 0;
+                for (size_t i = 0; i < n; ++i) {
+                    int sum = u[i + j] + v[i] + add_carry;
+                    add_carry = sum >= BASE;
+                    u[i + j] = add_carry ? sum - BASE : sum;
+                }
+                last += add_carry;
+            }
+            u[j + n] = (int)last;
+            quotient.digits[j] = (int)qhat;
+        }
+        quotient.trim();
+
+        BigNatural remainder = fromLimbs(u.data(), n);
+        return {quotient, divSmall(remainder, scale).first};
+    }
+
+    // floor(BASE^(2n) / b) for a divisor of n limbs, by Newton's iteration R' = R + R (1 - bR)
+    // in fixed point. The reciprocal of the top n / 2 + 2 limbs of b, computed the same way,
+    // is already right to about half the limbs, and one step doubles that. Any error of a few
+    // units left by truncation is then corrected exactly against the remainder
+    // BASE^(2n) - bR, so every level returns the exact floor. O(M(n)), a few multiplications
+    // of the current size at each level.
+    static BigNatural reciprocal(const BigNatural& b) {
+        size_t n = b.digits.size();
+        BigNatural scaled_one = shiftUp(BigNatural(1), 2 * n);
+        if (n <= 16) return divKnuth(scaled_one, b).first;
+
+        size_t h = n / 2 + 2;
+        BigNatural r = shiftUp(reciprocal(shiftDown(b, n - h)), n - h);
+
+        BigNatural product = b * r;
+        if (product <= scaled_one) {
+            r = r + shiftDown(r * (scaled_one - product), 2 * n);
+        } else {
+            r = r - shiftDown(r * (product - scaled_one), 2 * n) - BigNatural(1);
+        }
+
+        product = b * r;
+        while (product > scaled_one) {
+            r = r - BigNatural(1);
+            product = product - b;
+        }
+        BigNatural error = scaled_one - product;
+        while (error >= b) {
+            r = r + BigNatural(1);
+            error = error - b;
+        }
+        return r;
+    }
+
+    // With R = floor(BASE^(2n) / b), the quotient of any x < b * BASE^n is at most two more
+    // than floor(x R / BASE^(2n)). The dividend is taken n limbs at a time from the top, with
+    // the remainder so far in front, so each step is one such x and two multiplications.
+    static std::pair<BigNatural, BigNatural> divNewton(const BigNatural& a, const BigNatural& b) {
+        size_t n = b.digits.size();
+        BigNatural r = reciprocal(b);
+
+        BigNatural quotient;
+        quotient.digits.assign(a.digits.size(), 0);
+        BigNatural remainder;
+        size_t blocks = (a.digits.size() + n - 1) / n;
+        for (size_t block = blocks; block-- > 0;) {
+            size_t offset = block * n;
+            size_t len = std::min(n, a.digits.size() - offset);
+            BigNatural x = shiftUp(remainder, len) + fromLimbs(a.digits.data() + offset, len);
+
+            BigNatural q = shiftDown(x * r, 2 * n);
+            remainder = x - q * b;
+            while (remainder >= b) {
+                remainder = remainder - b;
+                q = q + BigNatural(1);
+            }
+            if (!q.isZero()) std::copy(q.digits.begin(), q.digits.end(), quotient.digits.begin() + offset);
+        }
+        quotient.trim();
+        return {quotient, remainder};
+    }
+
+public:
+    BigNatural operator/(const BigNatural& other) const {
+
+        return div_mod(*this, other).first;
+    }
+
+    BigNatural operator%(const BigNatural& other) const {
+        return div_mod(*this, other).second;
+    }
+
+    bool isZero() const {
+        return digits.size() == 1 && digits[0] == 0;
+    }
+};
+
+class BigInt {
+private:
+    BigNatural value;
+    bool is_negative;
+
+public:
+    BigInt() : value(0), is_negative(false) {}
+
+    BigInt(long long n) {
+        if (n < 0) {
+            is_negative = true;
+            if (n == std::numeric_limits<long long>::min()) {
+                 value = BigNatural(std::to_string(n).substr(1));
+            } else {
+                value = BigNatural((unsigned long long)(-n));
+            }
+        } else {
+            is_negative = false;
+            value = BigNatural((unsigned long long)n);
+        }
+    }
+
+    BigInt(std::string s) {
+        if (s.empty()) { value = 0; is_negative = false; return; }
+        if (s[0] == '-') {
+            is_negative = true;
+            value = BigNatural(s.substr(1));
+        } else {
+            is_negative = false;
+            value = BigNatural(s);
+        }
+        if (value.isZero()) is_negative = false;
+    }
+
+    BigInt(BigNatural val, bool neg) : value(val), is_negative(neg) {
+        if (val.isZero()) is_negative = false;
+    }
+
+    std::string toString() const {
+        std::string s = value.toString();
+        if (is_negative && s != "0") return "-" + s;
+        return s;
+    }
+
+    long long toLongLong() const {
+        long long res = value.toLongLong();
+        if (is_negative) return -res;
+        return res;
+    }
+
+    bool operator==(const BigInt& other) const {
+        return is_negative == other.is_negative && value == other.value;
+    }
+    bool operator!=(const BigInt& other) const { return !(*this == other); }
+
+    bool operator<(const BigInt& other) const {
+        if (is_negative != other.is_negative) return is_negative;
+        if (is_negative) return value > other.value;
+        return value < other.value;
+    }
+    bool operator>(const BigInt& other) const { return other < *this; }
+    bool operator<=(const BigInt& other) const { return !(*this > other); }
+    bool operator>=(const BigInt& other) const { return !(*this < other); }
+
+    BigInt operator-() const {
+        if (value.isZero()) return *this;
+        return BigInt(value, !is_negative);
+    }
+
+    BigInt operator+(const BigInt& other) const {
+        if (is_negative == other.is_negative) {
+            return BigInt(value + other.value, is_negative);
+        }
+        if (value >= other.value) {
+            return BigInt(value - other.value, is_negative);
+        } else {
+            return BigInt(other.value - value, other.is_negative);
+        }
+    }
+
+    BigInt operator-(const BigInt& other) const {
+        return *this + (-other);
+    }
+
+    BigInt operator*(const BigInt& other) const {
+        return BigInt(value * other.value, is_negative != other.is_negative);
+    }
+
+    BigInt operator/(const BigInt& other) const {
+        if (other.value.isZero()) throw std::runtime_error("Division by zero");
+        return BigInt(value / other.value, is_negative != other.is_negative);
+    }
+
+    BigInt operator%(const BigInt& other) const {
+        return BigInt(value % other.value, is_negative);
+    }
+
+    static BigInt pow(BigInt base, BigInt exp) {
+        if (exp < BigInt(0)) throw std::runtime_error("Negative exponent not supported");
+        BigInt res(1);
+        while (exp > BigInt(0)) {
+            if (exp % BigInt(2) != BigInt(0)) res = res * base;
+            base = base * base;
+            exp = exp / BigInt(2);
+        }
+        return res;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const BigInt& bi) {
+        os << bi.toString();
+        return os;
+    }
+};
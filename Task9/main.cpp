@@ -6,303 +6,10 @@
 #include <sstream>
 #include <cassert>
 #include <limits>
-using namespace std;
-
-class BigNatural {
-protected:
-    vector<int> digits;
-    static const int BASE = 1000000000;
-
-    void trim() {
-        while (digits.size() > 1 && digits.back() == 0) {
-            digits.pop_back();
-        }
-    }
-
-public:
-    BigNatural() {
-        digits.push_back(0);
-    }
-
-    BigNatural(unsigned long long n) {
-        if (n == 0) digits.push_back(0);
-        while (n > 0) {
-            digits.push_back(n % BASE);
-            n /= BASE;
-        }
-    }
-
-    BigNatural(string s) {
-        if (s.empty()) {
-            digits.push_back(0);
-        } else {
-            for (int i = (int)s.length(); i > 0; i -= 9) {
-                if (i < 9)
-                    digits.push_back(stoi(s.substr(0, i)));
-                else
-                    digits.push_back(stoi(s.substr(i - 9, 9)));
-            }
-        }
-        trim();
-    }
-
-    string toString() const {
-        if (digits.empty()) return "0";
-        string s = to_string(digits.back());
-        for (int i = (int)digits.size() - 2; i >= 0; --i) {
-            string tmp = to_string(digits[i]);
-            while (tmp.length() < 9) tmp = "0" + tmp;
-            s += tmp;
-        }
-        return s;
-    }
-
-    long long toLongLong() const {
-        long long res = 0;
-        long long multiplier = 1;
-        if (digits.size() > 3) throw out_of_range("BigNatural too large for long long");
-
-        for (size_t i = 0; i < digits.size(); ++i) {
-            res += digits[i] * multiplier;
-            multiplier *= BASE;
-        }
-        return res;
-    }
-
-    bool operator==(const BigNatural& other) const {
-        return digits == other.digits;
-    }
-
-    bool operator!=(const BigNatural& other) const {
-        return !(*this == other);
-    }
-
-    bool operator<(const BigNatural& other) const {
-        if (digits.size() != other.digits.size())
-            return digits.size() < other.digits.size();
-        for (int i = digits.size() - 1; i >= 0; --i) {
-            if (digits[i] != other.digits[i])
-                return digits[i] < other.digits[i];
-        }
-        return false;
-    }
-
-    bool operator>(const BigNatural& other) const { return other < *this; }
-    bool operator<=(const BigNatural& other) const { return !(*this > other); }
-    bool operator>=(const BigNatural& other) const { return !(*this < other); }
-
-    BigNatural operator+(const BigNatural& other) const {
-        BigNatural res;
-        res.digits.clear();
-        int carry = 0;
-        size_t n = max(digits.size(), other.digits.size());
-
-        for (size_t i = 0; i < n || carry; ++i) {
-            long long sum = carry + (long long)(i < digits.size() ? digits[i] : 0)
-                                  + (long long)(i < other.digits.size() ? other.digits[i] : 0);
-            res.digits.push_back(sum % BASE);
-            carry = sum / BASE;
-        }
-        return res;
-    }
-
-    BigNatural operator-(const BigNatural& other) const {
-        if (*this < other) throw invalid_argument("Result of subtraction is negative (in BigNatural)");
-        BigNatural res;
-        res.digits.clear();
-        int borrow = 0;
-        for (size_t i = 0; i < digits.size(); ++i) {
-            long long sub = (long long)digits[i] - borrow - (i < other.digits.size() ? other.digits[i] : 0);
-            if (sub < 0) {
-                sub += BASE;
-                borrow = 1;
-            } else {
-                borrow = 0;
-            }
-            res.digits.push_back(sub);
-        }
-        res.trim();
-        return res;
-    }
-
-    BigNatural operator*(const BigNatural& other) const {
-        BigNatural res;
-        res.digits.resize(digits.size() + other.digits.size(), 0);
-
-        for (size_t i = 0; i < digits.size(); ++i) {
-            long long carry = 0;
-            for (size_t j = 0; j < other.digits.size() || carry; ++j) {
-                long long cur = res.digits[i + j] + digits[i] * 1LL * (j < other.digits.size() ? other.digits[j] : 0) + carry;
-                res.digits[i + j] = cur % BASE;
-                carry = cur / BASE;
-            }
-        }
-        res.trim();
-        return res;
-    }
-
-    static pair<BigNatural, BigNatural> div_mod(const BigNatural& a, const BigNatural& b) {
-        if (b.digits.size() == 1 && b.digits[0] == 0) throw runtime_error("Division by zero");
-        if (a < b) return {BigNatural(0), a};
-
-        BigNatural quotient;
-        quotient.digits.resize(a.digits.size());
-        BigNatural remainder = 0;
-
-        for (int i = a.digits.size() - 1; i >= 0; --i) {
-            if (!(remainder.digits.size() == 1 && remainder.digits[0] == 0)) {
-                remainder.digits.insert(remainder.digits.begin(), a.digits[i]);
-            } else {
-                remainder.digits[0] = a.digits[i];
-            }
-
-            int l = 0, r = BASE - 1;
-            int best = 0;
-            while (l <= r) {
-                int m = l + (r - l) / 2;
-                if (b * BigNatural(m) <= remainder) {
-                    best = m;
-                    l = m + 1;
-                } else {
-                    r = m - 1;
-                }
-            }
-
-            quotient.digits[i] = best;
-            remainder = remainder - (b * BigNatural(best));
-        }
-        quotient.trim();
-        remainder.trim();
-        return {quotient, remainder};
-    }
-
-    BigNatural operator/(const BigNatural& other) const {
+#include <random>
 
-        return div_mod(*this, other).first;
-    }
-
-    BigNatural operator%(const BigNatural& other) const {
-        return div_mod(*this, other).second;
-    }
-
-    bool isZero() const {
-        return digits.size() == 1 && digits[0] == 0;
-    }
-};
-
-class BigInt {
-private:
-    BigNatural value;
-    bool is_negative;
-
-public:
-    BigInt() : value(0), is_negative(false) {}
-
-    BigInt(long long n) {
-        if (n < 0) {
-            is_negative = true;
-            if (n == std::numeric_limits<long long>::min()) {
-                 value = BigNatural(to_string(n).substr(1));
-            } else {
-                value = BigNatural((unsigned long long)(-n));
-            }
-        } else {
-            is_negative = false;
-            value = BigNatural((unsigned long long)n);
-        }
-    }
-
-    BigInt(string s) {
-        if (s.empty()) { value = 0; is_negative = false; return; }
-        if (s[0] == '-') {
-            is_negative = true;
-            value = BigNatural(s.substr(1));
-        } else {
-            is_negative = false;
-            value = BigNatural(s);
-        }
-        if (value.isZero()) is_negative = false;
-    }
-
-    BigInt(BigNatural val, bool neg) : value(val), is_negative(neg) {
-        if (val.isZero()) is_negative = false;
-    }
-
-    string toString() const {
-        string s = value.toString();
-        if (is_negative && s != "0") return "-" + s;
-        return s;
-    }
-
-    long long toLongLong() const {
-        long long res = value.toLongLong();
-        if (is_negative) return -res;
-        return res;
-    }
-
-    bool operator==(const BigInt& other) const {
-        return is_negative == other.is_negative && value == other.value;
-    }
-    bool operator!=(const BigInt& other) const { return !(*this == other); }
-
-    bool operator<(const BigInt& other) const {
-        if (is_negative != other.is_negative) return is_negative;
-        if (is_negative) return value > other.value;
-        return value < other.value;
-    }
-    bool operator>(const BigInt& other) const { return other < *this; }
-    bool operator<=(const BigInt& other) const { return !(*this > other); }
-    bool operator>=(const BigInt& other) const { return !(*this < other); }
-
-    BigInt operator-() const {
-        if (value.isZero()) return *this;
-        return BigInt(value, !is_negative);
-    }
-
-    BigInt operator+(const BigInt& other) const {
-        if (is_negative == other.is_negative) {
-            return BigInt(value + other.value, is_negative);
-        }
-        if (value >= other.value) {
-            return BigInt(value - other.value, is_negative);
-        } else {
-            return BigInt(other.value - value, other.is_negative);
-        }
-    }
-
-    BigInt operator-(const BigInt& other) const {
-        return *this + (-other);
-    }
-
-    BigInt operator*(const BigInt& other) const {
-        return BigInt(value * other.value, is_negative != other.is_negative);
-    }
-
-    BigInt operator/(const BigInt& other) const {
-        if (other.value.isZero()) throw runtime_error("Division by zero");
-        return BigInt(value / other.value, is_negative != other.is_negative);
-    }
-
-    BigInt operator%(const BigInt& other) const {
-        return BigInt(value % other.value, is_negative);
-    }
-
-    static BigInt pow(BigInt base, BigInt exp) {
-        if (exp < BigInt(0)) throw runtime_error("Negative exponent not supported");
-        BigInt res(1);
-        while (exp > BigInt(0)) {
-            if (exp % BigInt(2) != BigInt(0)) res = res * base;
-            base = base * base;
-            exp = exp / BigInt(2);
-        }
-        return res;
-    }
-
-    friend ostream& operator<<(ostream& os, const BigInt& bi) {
-        os << bi.toString();
-        return os;
-    }
-};
+#include "bigint.h"
+using namespace std;
 
 void runTests() {
     cout << "Running extended tests..." << endl;
@@ -370,6 +77,89 @@ void runTests() {
     assert((BigInt("10") % BigInt("3")).toString() == "1");
     assert((BigInt("-10") % BigInt("3")).toString() == "-1");
 
+    // --- 7. Fast multiplication against the schoolbook reference ---
+    mt19937_64 rng(2024);
+    // Random limbs, with runs of zero and of 999999999 limbs to stress carries and borrows.
+    auto randomNatural = [&](size_t limbs) {
+        string s;
+        int pattern = rng() % 4;
+        for (size_t i = 0; i < limbs; ++i) {
+            unsigned long long limb = rng() % 1000000000;
+            if (pattern == 1 || (pattern == 3 && rng() % 4 == 0)) limb = 999999999;
+            if (pattern == 2 && rng() % 3 == 0) limb = 0;
+            string part = to_string(limb);
+            s += string(9 - part.size(), '0') + part;
+        }
+        if (s.empty() || s[0] == '0') s = "1" + s;
+        return BigNatural(s);
+    };
+    auto checkProducts = [&](int trials, size_t max_limbs) {
+        for (int t = 0; t < trials; ++t) {
+            BigNatural x = randomNatural(1 + rng() % max_limbs);
+            BigNatural y = randomNatural(1 + rng() % max_limbs);
+            assert(x * y == BigNatural::multiplySchoolbook(x, y));
+            assert(x * x == BigNatural::multiplySchoolbook(x, x));
+        }
+    };
+    checkProducts(60, 1500);
+    assert((BigNatural(0) * randomNatural(500)).isZero());
+
+    // Low thresholds, so that small operands go through several levels of Toom-3, Karatsuba
+    // and unbalanced splits.
+    size_t karatsuba = BigNatural::karatsubaThreshold, toom = BigNatural::toomThreshold;
+    BigNatural::karatsubaThreshold = 8;
+    BigNatural::toomThreshold = 12;
+    checkProducts(400, 200);
+    BigNatural::karatsubaThreshold = karatsuba;
+    BigNatural::toomThreshold = toom;
+    cout << "[OK] Karatsuba / Toom-3 multiplication matches schoolbook." << endl;
+
+    // --- 8. NTT multiplication ---
+    // With the threshold at 1 every product goes through the transforms, down to 1 x 1 limbs;
+    // operands of 3000 limbs need transforms larger than one cache block.
+    size_t ntt = BigNatural::nttThreshold;
+    BigNatural::nttThreshold = 1;
+    checkProducts(200, 40);
+    checkProducts(6, 3000);
+    BigNatural::nttThreshold = ntt;
+
+    // (10^k - 1)^2 = 10^2k - 2 * 10^k + 1: all-nines limbs give the largest coefficients.
+    size_t k = 450000;
+    BigNatural nines(string(k, '9'));
+    assert(nines * nines == BigNatural(string(k - 1, '9') + "8" + string(k - 1, '0') + "1"));
+    cout << "[OK] NTT multiplication matches schoolbook." << endl;
+
+    // --- 9. Division ---
+    // q * y + r == x with r < y pins down the quotient and the remainder. Small cases are also
+    // compared with the original binary-search division.
+    auto checkDivision = [&](const BigNatural& x, const BigNatural& y) {
+        pair<BigNatural, BigNatural> qr = BigNatural::div_mod(x, y);
+        assert(qr.second < y && qr.first * y + qr.second == x);
+    };
+    for (int t = 0; t < 300; ++t) {
+        BigNatural x = randomNatural(1 + rng() % 40), y = randomNatural(1 + rng() % 20);
+        checkDivision(x, y);
+        assert(BigNatural::div_mod(x, y) == BigNatural::divModBinarySearch(x, y));
+    }
+    // Divisors whose top limb is 1 or BASE - 1, and dividends whose top limbs equal them.
+    BigNatural base_power("1" + string(90, '0'));
+    checkDivision(base_power * base_power - BigNatural(1), base_power + BigNatural(1));
+    checkDivision(base_power * BigNatural(999999999), BigNatural("999999999" + string(45, '0') + "1"));
+    checkDivision(BigNatural(string(180, '9')), BigNatural(string(72, '9')));
+
+    size_t newton = BigNatural::newtonThreshold;
+    BigNatural::newtonThreshold = 2;
+    for (int t = 0; t < 60; ++t) {
+        checkDivision(randomNatural(1 + rng() % 400), randomNatural(1 + rng() % 200));
+    }
+    BigNatural::newtonThreshold = newton;
+    checkDivision(randomNatural(20000), randomNatural(8000));
+
+    BigInt two_power = BigInt::pow(BigInt(2), BigInt(3000));
+    assert(two_power / BigInt::pow(BigInt(2), BigInt(2998)) == BigInt(4));
+    assert((two_power % BigInt(1000000007)).toString() == "165700476");
+    cout << "[OK] Division (single limb, Knuth D, Newton) passed." << endl;
+
     cout << "ALL TESTS PASSED SUCCESSFULLY" << endl;
 }
 
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Exact multiplication of base-10^9 limb arrays by number-theoretic transforms. The limbs are
+// convolved modulo three primes of the form c * 2^k + 1 and the coefficients are rebuilt by
+// the Chinese remainder theorem. A coefficient is at most min(na, nb) * (10^9 - 1)^2, below
+// the product of the primes (about 7.9e25) for any length the transforms support, so no
+// rounding error is possible, unlike with floating-point FFTs. O(N log N).
+
+// Transforms modulo one prime MOD with primitive root ROOT. MOD is a template parameter so
+// that every `% MOD` is a multiplication by a constant.
+template <uint32_t MOD, uint32_t ROOT>
+struct NttPrime {
+    // Levels with butterflies spanning at most this many elements are done one block at a
+    // time, while the block is in L1 cache, instead of one pass over the whole array per level.
+    static constexpr size_t BLOCK = 1 << 12;
+
+    static uint32_t mul(uint32_t a, uint32_t b) {
+        return (uint32_t)((uint64_t)a * b % MOD);
+    }
+
+    static uint32_t power(uint32_t a, uint64_t e) {
+        uint32_t res = 1;
+        for (; e > 0; e >>= 1) {
+            if (e & 1) res = mul(res, a);
+            a = mul(a, a);
+        }
+        return res;
+    }
+
+    // roots[half + j] = w^j, where w is the (2 * half)-th root of unity (or its inverse), for
+    // every power of two half < n.
+    static std::vector<uint32_t> rootTable(size_t n, bool inverse) {
+        std::vector<uint32_t> roots(std::max<size_t>(n, 2));
+        for (size_t half = 1; half < n; half *= 2) {
+            uint32_t w = power(ROOT, (MOD - 1) / (2 * half));
+            if (inverse) w = power(w, MOD - 2);
+            uint32_t cur = 1;
+            for (size_t j = 0; j < half; ++j) {
+                roots[half + j] = cur;
+                cur = mul(cur, w);
+            }
+        }
+        return roots;
+    }
+
+    // Decimation in frequency: natural order in, bit-reversed order out.
+    static void forwardLevel(uint32_t* a, size_t size, size_t half, const uint32_t* roots) {
+        for (size_t i = 0; i < size; i += 2 * half) {
+            for (size_t j = 0; j < half; ++j) {
+                uint32_t u = a[i + j], v = a[i + j + half];
+                a[i + j] = u + v >= MOD ? u + v - MOD : u + v;
+                a[i + j + half] = mul(u >= v ? u - v : u + MOD - v, roots[half + j]);
+            }
+        }
+    }
+
+    // Decimation in time with the inverse roots: bit-reversed order in, natural order out.
+    static void inverseLevel(uint32_t* a, size_t size, size_t half, const uint32_t* roots) {
+        for (size_t i = 0; i < size; i += 2 * half) {
+            for (size_t j = 0; j < half; ++j) {
+                uint32_t u = a[i + j], v = mul(a[i + j + half], roots[half + j]);
+                a[i + j] = u + v >= MOD ? u + v - MOD : u + v;
+                a[i + j + half] = u >= v ? u - v : u + MOD - v;
+            }
+        }
+    }
+
+    static void forward(uint32_t* a, size_t n, const uint32_t* roots) {
+        size_t block = std::min(n, BLOCK);
+        size_t half = n / 2;
+        for (; half >= 1 && 2 * half > block; half /= 2) {
+            forwardLevel(a, n, half, roots);
+        }
+        for (size_t start = 0; start < n; start += block) {
+            for (size_t h = half; h >= 1; h /= 2) {
+                forwardLevel(a + start, block, h, roots);
+            }
+        }
+    }
+
+    // Also divides by n, so inverse(forward(a)) == a.
+    static void inverse(uint32_t* a, size_t n, const uint32_t* roots) {
+        size_t block = std::min(n, BLOCK);
+        for (size_t start = 0; start < n; start += block) {
+            for (size_t h = 1; 2 * h <= block; h *= 2) {
+                inverseLevel(a + start, block, h, roots);
+            }
+        }
+        for (size_t half = block; half < n; half *= 2) {
+            inverseLevel(a, n, half, roots);
+        }
+        uint32_t scale = power((uint32_t)n, MOD - 2);
+        for (size_t i = 0; i < n; ++i) {
+            a[i] = mul(a[i], scale);
+        }
+    }
+
+    // result[0, n) = a * b as a cyclic convolution modulo MOD; n is a power of two no less
+    // than na + nb - 1. A square (a == b) takes one forward transform instead of two.
+    static void convolve(const int* a, size_t na, const int* b, size_t nb, size_t n, uint32_t* result) {
+        std::vector<uint32_t> forward_roots = rootTable(n, false);
+        std::fill(result, result + n, 0);
+        for (size_t i = 0; i < na; ++i) {
+            result[i] = (uint32_t)a[i] % MOD;
+        }
+        forward(result, n, forward_roots.data());
+
+        if (a == b && na == nb) {
+            for (size_t i = 0; i < n; ++i) {
+                result[i] = mul(result[i], result[i]);
+            }
+        } else {
+            std::vector<uint32_t> other(n, 0);
+            for (size_t i = 0; i < nb; ++i) {
+                other[i] = (uint32_t)b[i] % MOD;
+            }
+            forward(other.data(), n, forward_roots.data());
+            for (size_t i = 0; i < n; ++i) {
+                result[i] = mul(result[i], other[i]);
+            }
+        }
+        forward_roots.clear();
+        forward_roots.shrink_to_fit();
+
+        inverse(result, n, rootTable(n, true).data());
+    }
+};
+
+using NttPrime1 = NttPrime<998244353, 3>;   // 119 * 2^23 + 1
+using NttPrime2 = NttPrime<167772161, 3>;   // 5 * 2^25 + 1
+using NttPrime3 = NttPrime<469762049, 3>;   // 7 * 2^26 + 1
+
+// The longest product (in limbs) the transforms can handle: 2^23 is the largest power of two
+// dividing 998244353 - 1.
+const size_t NTT_MAX_LENGTH = size_t(1) << 23;
+
+// out[0, na + nb) = a * b for base-10^9 limbs, na + nb <= NTT_MAX_LENGTH. Allocates its
+// own arrays of the transform length (about 6 * 4 bytes per point at the peak).
+inline void nttMultiply(const int* a, size_t na, const int* b, size_t nb, int* out) {
+    const uint64_t BASE = 1000000000;
+    const uint64_t M1 = 998244353, M2 = 167772161, M3 = 469762049;
+
+    size_t len = na + nb;
+    size_t n = 1;
+    while (n < len - 1) n *= 2;
+
+    std::vector<uint32_t> r1(n), r2(n), r3(n);
+    NttPrime1::convolve(a, na, b, nb, n, r1.data());
+    NttPrime2::convolve(a, na, b, nb, n, r2.data());
+    NttPrime3::convolve(a, na, b, nb, n, r3.data());
+
+    // Garner: x = t1 + M1 * (t2 + M2 * t3) with t1 < M1, t2 < M2, t3 < M3. The part in
+    // brackets, y < M2 * M3 < 2^58, is split at 10^9 so that every product fits in 64 bits.
+    const uint64_t INV_M1_MOD_M2 = NttPrime2::power(M1 % M2, M2 - 2);
+    const uint64_t INV_M1M2_MOD_M3 = NttPrime3::power((uint32_t)(M1 % M3 * (M2 % M3) % M3), M3 - 2);
+    uint64_t carry = 0;
+    for (size_t i = 0; i < len; ++i) {
+        uint64_t value = carry;
+        carry = 0;
+        if (i + 1 < len) {
+            uint64_t t1 = r1[i];
+            uint64_t t2 = (r2[i] + M2 - t1 % M2) * INV_M1_MOD_M2 % M2;
+            uint64_t t3 = (r3[i] + 2 * M3 - t1 % M3 - t2 * (M1 % M3) % M3) % M3 * INV_M1M2_MOD_M3 % M3;
+            uint64_t y = t2 + M2 * t3;
+            value += t1 + M1 * (y % BASE);
+            carry = M1 * (y / BASE);
+        }
+        out[i] = (int)(value % BASE);
+        carry += value / BASE;
+    }
+}